@@ -15,12 +15,17 @@
 #include "checkpointing/datatypes/PersonTDDataType.h"
 #include "checkpointing/datatypes/PersonTIDataType.h"
 #include "checkpointing/datatypes/TravellerDataType.h"
+#include "checkpointing/Hdf5Writer.h"
 #include "sim/SimulatorBuilder.h"
 #include "pop/PopulationBuilder.h"
 #include "core/Cluster.h"
 #include "util/etc.h"
 
 #include <algorithm>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <type_traits>
 #include <vector>
 #include <string>
 
@@ -33,8 +38,8 @@ using namespace stride::util;
 namespace stride {
 
 
-Hdf5Loader::Hdf5Loader(const char* filename) :
-		m_filename(filename) {
+Hdf5Loader::Hdf5Loader(const char* filename, const string& group) :
+		m_filename(filename), m_root(group.empty() ? "" : "/" + group) {
 
 	try {
 		this->loadConfigs();
@@ -44,9 +49,11 @@ Hdf5Loader::Hdf5Loader(const char* filename) :
 }
 
 void Hdf5Loader::loadConfigs() {
+	// Savers may still be writing checkpoints (of other simulators) in the background, see Hdf5Writer.
+	lock_guard<mutex> lock(Hdf5Writer::getLibraryMutex());
 	H5File file(m_filename, H5F_ACC_RDONLY, H5P_DEFAULT, H5P_DEFAULT);
 
-	DataSet dataset = DataSet(file.openDataSet("Configuration/configuration"));
+	DataSet dataset = DataSet(file.openDataSet(m_root + "/Configuration/configuration"));
 	ConfigDataType configData[1];
 	dataset.read(configData, ConfigDataType::getCompType());
 	dataset.close();
@@ -65,15 +72,30 @@ void Hdf5Loader::loadConfigs() {
 
 
 void Hdf5Loader::loadFromTimestep(unsigned int timestep, std::shared_ptr<Simulator> sim) const {
+	// Held for the whole load, the reads in the background (see loadPersonTDData) included.
+	lock_guard<mutex> lock(Hdf5Writer::getLibraryMutex());
 	H5File file(m_filename, H5F_ACC_RDONLY, H5P_DEFAULT, H5P_DEFAULT);
 
-	stringstream ss;
-	ss << "/Timestep_" << std::setfill('0') << std::setw(6) << timestep;
-	string dataset_name = ss.str();
+	auto group_name = [this](unsigned int timestep) {
+		stringstream ss;
+		ss << m_root << "/Timestep_" << std::setfill('0') << std::setw(6) << timestep;
+		return ss.str();
+	};
+	string dataset_name = group_name(timestep);
 
+	// A delta checkpoint only holds the changes since the previous checkpoint: go back to the last
+	// full checkpoint (keyframe) and apply the changes of the ones after it in order.
+	vector<string> checkpoints {dataset_name};
+	while (H5Lexists(file.getId(), (checkpoints.back() + "/previous_timestep").c_str(), H5P_DEFAULT) > 0) {
+		checkpoints.push_back(group_name(readNumbers(file, checkpoints.back() + "/previous_timestep").at(0)));
+	}
+	std::reverse(checkpoints.begin(), checkpoints.end());
 
 	this->loadCalendar(file, dataset_name, sim);
-	this->loadPersonTDData(file, dataset_name, sim);
+	this->loadPersonTDData(file, checkpoints.front(), sim);
+	for (size_t i = 1; i < checkpoints.size(); i++) {
+		this->loadPersonTDDelta(file, checkpoints[i], sim);
+	}
 	this->loadTravellers(file, dataset_name, sim);
 
 	// Sort the population by id first, in order to increase the speed of cluster reordening
@@ -82,13 +104,18 @@ void Hdf5Loader::loadFromTimestep(unsigned int timestep, std::shared_ptr<Simulat
 	};
 	std::sort(sim->m_population->m_original.begin(), sim->m_population->m_original.end(), sortByID);
 
-	this->loadClusters(file, dataset_name + "/household_clusters", sim->m_households, sim);
-	this->loadClusters(file, dataset_name + "/school_clusters", sim->m_school_clusters, sim);
-	this->loadClusters(file, dataset_name + "/work_clusters", sim->m_work_clusters, sim);
-	this->loadClusters(file, dataset_name + "/primary_community_clusters", sim->m_primary_community, sim);
-	this->loadClusters(file, dataset_name + "/secondary_community_clusters", sim->m_secondary_community, sim);
+	// A delta holds no clusters: the members follow from the population and the travellers (loaded above),
+	// their order from the health of the members.
+	if (checkpoints.size() == 1) {
+		this->loadClusters(file, dataset_name, "household_clusters", sim->m_households, sim);
+		this->loadClusters(file, dataset_name, "school_clusters", sim->m_school_clusters, sim);
+		this->loadClusters(file, dataset_name, "work_clusters", sim->m_work_clusters, sim);
+		this->loadClusters(file, dataset_name, "primary_community_clusters", sim->m_primary_community, sim);
+		this->loadClusters(file, dataset_name, "secondary_community_clusters", sim->m_secondary_community, sim);
+	}
 
-	this->updateClusterImmuneIndices(sim);
+	sim->m_population->syncColumns();
+	this->sortClusterMembers(sim);
 
 	if (sim->m_rng != nullptr) {
 		this->loadRngState(file, dataset_name, sim);
@@ -99,8 +126,9 @@ void Hdf5Loader::loadFromTimestep(unsigned int timestep, std::shared_ptr<Simulat
 
 
 unsigned int Hdf5Loader::getLastSavedTimestep() const {
+	lock_guard<mutex> lock(Hdf5Writer::getLibraryMutex());
 	H5File file(m_filename, H5F_ACC_RDONLY, H5P_DEFAULT, H5P_DEFAULT);
-	DataSet dataset = DataSet(file.openDataSet("last_timestep"));
+	DataSet dataset = DataSet(file.openDataSet(m_root + "/last_timestep"));
 	unsigned int data[1];
 	dataset.read(data, PredType::NATIVE_UINT);
 	dataset.close();
@@ -109,21 +137,18 @@ unsigned int Hdf5Loader::getLastSavedTimestep() const {
 }
 
 
-void Hdf5Loader::updateClusterImmuneIndices(std::shared_ptr<Simulator> sim) const {
-	for (auto cluster : sim->m_households) {
-		cluster.m_index_immune = cluster.m_members.size() - 1;
-	}
-	for (auto cluster : sim->m_school_clusters) {
-		cluster.m_index_immune = cluster.m_members.size() - 1;
-	}
-	for (auto cluster : sim->m_work_clusters) {
-		cluster.m_index_immune = cluster.m_members.size() - 1;
-	}
-	for (auto cluster : sim->m_primary_community) {
-		cluster.m_index_immune = cluster.m_members.size() - 1;
+void Hdf5Loader::sortClusterMembers(std::shared_ptr<Simulator> sim) const {
+	// Only the infector without local information reorders the members, and the order it gives them only
+	// depends on their health (see Cluster::sortMembers), so it is rebuilt here rather than saved.
+	if (!is_same<Simulator::LocalInformationPolicy, NoLocalInformation>::value) {
+		return;
 	}
-	for (auto cluster : sim->m_secondary_community) {
-		cluster.m_index_immune = cluster.m_members.size() - 1;
+	for (auto clusters: {&sim->m_households, &sim->m_school_clusters, &sim->m_work_clusters,
+						 &sim->m_primary_community, &sim->m_secondary_community}) {
+		for (auto& cluster: *clusters) {
+			cluster.m_index_immune = cluster.m_members.size();
+			cluster.sortMembers();
+		}
 	}
 }
 
@@ -174,7 +199,7 @@ void Hdf5Loader::loadTravellers(H5File& file, string dataset_name, shared_ptr<Si
 			person.m_health.m_disease_counter = object.m_disease_counter;
 			person.m_is_participant = object.m_participant;
 
-			sim->m_population->m_visitors.add(object.m_days_left, person);
+			const PersonIndex person_index = sim->m_population->addVisitor(object.m_days_left, person);
 
 			// Secondly, add the traveller to the planner in the simulator
 
@@ -191,7 +216,7 @@ void Hdf5Loader::loadTravellers(H5File& file, string dataset_name, shared_ptr<Si
 			string dest_sim_name = object.m_dest_sim_name;
 
 			Simulator::TravellerType traveller = Simulator::TravellerType(
-					original_person, sim->m_population->m_visitors.getModifiableDay(object.m_days_left)->back().get(),
+					original_person, &sim->m_population->getPerson(person_index),
 					home_sim_name, dest_sim_name, object.m_home_sim_index);
 
 			traveller.getNewPerson()->setOnVacation(false);
@@ -199,12 +224,12 @@ void Hdf5Loader::loadTravellers(H5File& file, string dataset_name, shared_ptr<Si
 
 
 			// Finally, add the traveller to clusters
-			Simulator::PersonType* added_person = sim->m_population->m_visitors.getModifiableDay(
-					object.m_days_left)->back().get();
-
-			sim->m_work_clusters.at(object.m_new_work_id).addPerson(added_person);
-			sim->m_primary_community.at(object.m_new_prim_comm_id).addPerson(added_person);
-			sim->m_secondary_community.at(object.m_new_sec_comm_id).addPerson(added_person);
+			sim->m_work_clusters.at(object.m_new_work_id).addPerson(person_index);
+			sim->m_primary_community.at(object.m_new_prim_comm_id).addPerson(person_index);
+			sim->m_secondary_community.at(object.m_new_sec_comm_id).addPerson(person_index);
+			sim->updateContactProbabilities(sim->m_work_clusters.at(object.m_new_work_id));
+			sim->updateContactProbabilities(sim->m_primary_community.at(object.m_new_prim_comm_id));
+			sim->updateContactProbabilities(sim->m_secondary_community.at(object.m_new_sec_comm_id));
 
 
 			// Since the travellers are ordered, it is safe to set these values every iteration
@@ -222,29 +247,49 @@ void Hdf5Loader::loadTravellers(H5File& file, string dataset_name, shared_ptr<Si
 
 void Hdf5Loader::loadPersonTDData(H5File& file, string dataset_name, shared_ptr<Simulator> sim) const {
 	DataSet dataset = DataSet(file.openDataSet(dataset_name + "/person_time_dependent"));
-	unsigned long dims[1] = {sim->m_population.get()->m_original.size()};
+	auto& population = sim->m_population->m_original;
+	const hsize_t num_persons = population.size();
 	CompType type_person_TD = PersonTDDataType::getCompType();
 
-	for (unsigned int i = 0; i < dims[0]; i++) {
-		PersonTDDataType person[1];
-		hsize_t dim_sub[1] = {1};
-
-		DataSpace memspace(1, dim_sub, NULL);
-
-		hsize_t offset[1] = {i};
-		hsize_t count[1] = {1};
-		hsize_t stride[1] = {1};
-		hsize_t block[1] = {1};
-
-		DataSpace dataspace = dataset.getSpace();
-		dataspace.selectHyperslab(H5S_SELECT_SET, count, offset, stride, block);
-		dataset.read(person, type_person_TD, memspace, dataspace);
-		sim->m_population->m_original.at(i).m_is_participant = person[0].m_participant;
-		sim->m_population->m_original.at(i).m_health.m_status = HealthStatus(person[0].m_health_status);
-		sim->m_population->m_original.at(i).m_health.m_disease_counter = person[0].m_disease_counter;
-		sim->m_population->m_original.at(i).m_is_on_vacation = person[0].m_on_vacation;
+	// Persons are read per chunk into one of two buffers: the next chunk is read while the persons of the
+	// current one are updated. The chunks they were saved in are configurable (see Hdf5Profile), so a read
+	// may span several of them and start or end halfway one, the library handles that.
+	const hsize_t chunk_size = 40000;
+	auto read_chunk = [&](hsize_t offset, vector<PersonTDDataType>& buffer) {
+		hsize_t selected_dims[1] = {min(chunk_size, num_persons - offset)};
+		hsize_t start[1] = {offset};
+		buffer.resize(selected_dims[0]);
+
+		DataSpace memspace(1, selected_dims, NULL);
+		DataSpace filespace = dataset.getSpace();
+		filespace.selectHyperslab(H5S_SELECT_SET, selected_dims, start);
+		dataset.read(buffer.data(), type_person_TD, memspace, filespace);
 		memspace.close();
-		dataspace.close();
+		filespace.close();
+	};
+
+	vector<PersonTDDataType> buffers[2];
+	if (num_persons > 0) {
+		read_chunk(0, buffers[0]);
+	}
+	for (hsize_t offset = 0, current = 0; offset < num_persons; offset += chunk_size, current = 1 - current) {
+		// The read runs under the library lock of loadFromTimestep, this thread does not call HDF5 meanwhile
+		// (nor does the read touch the population).
+		future<void> next_read;
+		if (offset + chunk_size < num_persons) {
+			next_read = async(launch::async, read_chunk, offset + chunk_size, ref(buffers[1 - current]));
+		}
+		const auto& persons = buffers[current];
+		for (size_t j = 0; j < persons.size(); j++) {
+			auto& person = population[offset + j];
+			person.m_is_participant = persons[j].m_participant;
+			person.m_health.m_status = HealthStatus(persons[j].m_health_status);
+			person.m_health.m_disease_counter = persons[j].m_disease_counter;
+			person.m_is_on_vacation = persons[j].m_on_vacation;
+		}
+		if (next_read.valid()) {
+			next_read.get();
+		}
 	}
 	dataset.close();
 }
@@ -260,22 +305,47 @@ void Hdf5Loader::loadRngState(H5File& file, string dataset_name, shared_ptr<Simu
 }
 
 
-void Hdf5Loader::loadClusters(H5File& file, std::string full_dataset_name, std::vector<Cluster>& cluster,
-							  std::shared_ptr<Simulator> sim) const {
-	std::shared_ptr<Population> pop = sim->m_population;
-
+vector<unsigned int> Hdf5Loader::readNumbers(H5File& file, string full_dataset_name) {
 	DataSet dataset = DataSet(file.openDataSet(full_dataset_name));
 	DataSpace dataspace = dataset.getSpace();
-	hsize_t dims_clusters[1];
-	dataspace.getSimpleExtentDims(dims_clusters, NULL);
-	const unsigned int amtIds = dims_clusters[0];
+	hsize_t dims[1];
+	dataspace.getSimpleExtentDims(dims, NULL);
 	dataspace.close();
 
-	unsigned int cluster_data[amtIds];
-	unsigned int index = 0;
-
-	dataset.read(cluster_data, PredType::NATIVE_UINT);
+	vector<unsigned int> numbers(dims[0]);
+	if (!numbers.empty()) {
+		dataset.read(numbers.data(), PredType::NATIVE_UINT);
+	}
 	dataset.close();
+	return numbers;
+}
+
+
+void Hdf5Loader::loadPersonTDDelta(H5File& file, string dataset_name, shared_ptr<Simulator> sim) const {
+	const vector<unsigned int> changed_persons = readNumbers(file, dataset_name + "/changed_persons");
+	vector<PersonTDDataType> persons(changed_persons.size());
+	if (!persons.empty()) {
+		DataSet dataset = DataSet(file.openDataSet(dataset_name + "/person_time_dependent"));
+		dataset.read(persons.data(), PersonTDDataType::getCompType());
+		dataset.close();
+	}
+
+	auto& population = sim->m_population->m_original;
+	for (size_t j = 0; j < persons.size(); j++) {
+		auto& person = population.at(changed_persons[j]);
+		person.m_is_participant = persons[j].m_participant;
+		person.m_health.m_status = HealthStatus(persons[j].m_health_status);
+		person.m_health.m_disease_counter = persons[j].m_disease_counter;
+		person.m_is_on_vacation = persons[j].m_on_vacation;
+	}
+}
+
+
+void Hdf5Loader::loadClusters(H5File& file, string dataset_name, string cluster_name,
+							  std::vector<Cluster>& cluster, std::shared_ptr<Simulator> sim) const {
+	std::shared_ptr<Population> pop = sim->m_population;
+	const vector<unsigned int> cluster_data = readNumbers(file, dataset_name + "/" + cluster_name);
+	unsigned int index = 0;
 
 	// Collect all the travellers in a single vector for convenience
 	vector<Simulator::PersonType*> travellers;
@@ -290,8 +360,8 @@ void Hdf5Loader::loadClusters(H5File& file, std::string full_dataset_name, std::
 			unsigned int id = cluster_data[index++];
 
 			if (id < pop->m_original.size()) {
-				Simulator::PersonType* person = &pop->m_original.at(id);
-				cluster.at(i).m_members.at(j).first = person;
+				// The population is sorted by id, so the id is also the index
+				cluster.at(i).m_members.at(j) = id;
 			} else {
 				// Get the pointer to the person via the travel planner
 				auto traveller = std::find_if(
@@ -300,7 +370,7 @@ void Hdf5Loader::loadClusters(H5File& file, std::string full_dataset_name, std::
 						[&id](Simulator::PersonType* traveller) -> bool {
 							return (traveller)->getId() == id;
 						});
-				cluster.at(i).m_members.at(j).first = (*traveller);
+				cluster.at(i).m_members.at(j) = pop->getIndex(*traveller);
 			}
 
 		}
@@ -320,13 +390,15 @@ void Hdf5Loader::extractConfigs(string filename) {
 							system_complete(filename).string() + " is not a regular file.");
 	}
 
-	H5File file(filename, H5F_ACC_RDONLY, H5P_DEFAULT, H5P_DEFAULT);
-
-	DataSet dataset = DataSet(file.openDataSet("Configuration/configuration"));
 	ConfigDataType configData[1];
-	dataset.read(configData, ConfigDataType::getCompType());
-	dataset.close();
-	file.close();
+	{
+		lock_guard<mutex> lock(Hdf5Writer::getLibraryMutex());
+		H5File file(filename, H5F_ACC_RDONLY, H5P_DEFAULT, H5P_DEFAULT);
+		DataSet dataset = DataSet(file.openDataSet("Configuration/configuration"));
+		dataset.read(configData, ConfigDataType::getCompType());
+		dataset.close();
+		file.close();
+	}
 
 	auto writeToFile = [](string filename, string content) {
 		std::ofstream file;
@@ -16,6 +16,7 @@
 #include <boost/property_tree/xml_parser.hpp>
 #include <string>
 #include <memory>
+#include <vector>
 
 using namespace boost::property_tree;
 using std::shared_ptr;
@@ -27,7 +28,8 @@ namespace stride {
 class Hdf5Loader {
 #ifdef HDF5_USED
 public:
-	Hdf5Loader(const char* filename);
+	/// Loads the checkpoints in the group with the given name ("" is the root of the file, see Hdf5Writer).
+	Hdf5Loader(const char* filename, const string& group = "");
 
 	/// Load from timestep, if the specified timestep is present in the hdf5 file.
 	void loadFromTimestep(unsigned int timestep, shared_ptr<Simulator> sim) const;
@@ -54,12 +56,12 @@ public:
 
 
 private:
-	/// Sets the cluster immune indices to their maximum, so that sortCluster will definitely sort all members.
-	void updateClusterImmuneIndices(shared_ptr<Simulator> sim) const;
+	/// Puts the members of every cluster in the order Cluster::sortMembers gives them (from their health).
+	void sortClusterMembers(shared_ptr<Simulator> sim) const;
 
-	/// Reoders the cluster member positions according to the loaded timestep data.
-	void loadClusters(H5::H5File& file, string full_dataset_name, std::vector<Cluster>& cluster,
-					  shared_ptr<Simulator> sim) const;
+	/// Reoders the cluster member positions according to the loaded timestep data (of a keyframe).
+	void loadClusters(H5::H5File& file, string dataset_name, string cluster_name,
+					  std::vector<Cluster>& cluster, shared_ptr<Simulator> sim) const;
 
 	/// Loads the calendar data.
 	void loadCalendar(H5::H5File& file, string dataset_name, shared_ptr<Simulator> sim) const;
@@ -67,7 +69,13 @@ private:
 	/// Load the time dependent person data
 	void loadPersonTDData(H5::H5File& file, string dataset_name, shared_ptr<Simulator> sim) const;
 
-	/// Load the rng state (NOTE only happens when stride runs without parallelisation).
+	/// Load the time dependent data of the persons that changed in a delta checkpoint.
+	void loadPersonTDDelta(H5::H5File& file, string dataset_name, shared_ptr<Simulator> sim) const;
+
+	/// Read a dataset of unsigned numbers.
+	static std::vector<unsigned int> readNumbers(H5::H5File& file, string full_dataset_name);
+
+	/// Load the rng state (the streams of the cluster blocks are seeded from it each day).
 	void loadRngState(H5::H5File& file, string dataset_name, shared_ptr<Simulator> sim) const;
 
 	/// Loads the travellers if present.
@@ -79,6 +87,7 @@ private:
 
 private:
 	const char* m_filename;
+	string m_root;     ///< Path of the group of the checkpoints.
 
 	ptree m_pt_config;
 	ptree m_pt_disease;
@@ -87,7 +96,7 @@ private:
 #ifndef HDF5_USED
 	// These dummy headers are used as an interface for when no hdf5 is included, but everything still needs to compile.
 	public:
-		Hdf5Loader(const char* filename) {}
+		Hdf5Loader(const char* filename, const string& group = "") {}
 
 		/// Load from timestep, if the specified timestep is present in the hdf5 file.
 		void loadFromTimestep(unsigned int timestep, shared_ptr<Simulator> sim) const {}
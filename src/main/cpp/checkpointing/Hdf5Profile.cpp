@@ -0,0 +1,75 @@
+/**
+ * @file
+ * Source file for the layout and filters of the datasets in a checkpoint file.
+ */
+
+#include "Hdf5Profile.h"
+#include "util/StringUtils.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace H5;
+using namespace std;
+using namespace stride::util;
+
+namespace stride {
+
+Hdf5Profile::Hdf5Profile()
+		: m_chunk_size(10000), m_shuffle(false), m_deflate_level(0), m_filter(H5Z_FILTER_NONE) {
+}
+
+Hdf5Profile::Hdf5Profile(const boost::property_tree::ptree& pt_checkpointing)
+		: Hdf5Profile() {
+	m_chunk_size = pt_checkpointing.get<hsize_t>("<xmlattr>.chunk_size", m_chunk_size);
+	m_shuffle = pt_checkpointing.get<bool>("<xmlattr>.shuffle", m_shuffle);
+
+	const auto compression = pt_checkpointing.get<string>("<xmlattr>.compression", "none");
+	if (compression == "deflate") {
+		m_deflate_level = pt_checkpointing.get<int>("<xmlattr>.compression_level", 6);
+		if (m_deflate_level < 1 || m_deflate_level > 9) {
+			throw runtime_error(string(__func__) + "> Compression level should be in [1, 9].");
+		}
+	} else if (compression != "none") {
+		throw runtime_error(string(__func__) + "> Invalid compression " + compression + " (none or deflate).");
+	}
+
+	m_filter = pt_checkpointing.get<H5Z_filter_t>("<xmlattr>.filter", H5Z_FILTER_NONE);
+	const auto filter_params = pt_checkpointing.get<string>("<xmlattr>.filter_params", "");
+	if (!filter_params.empty()) {
+		for (const auto& param: StringUtils::split(filter_params, ",")) {
+			m_filter_params.push_back(StringUtils::fromString<unsigned int>(StringUtils::trim(param)));
+		}
+	}
+	if (m_filter != H5Z_FILTER_NONE && H5Zfilter_avail(m_filter) <= 0) {
+		throw runtime_error(string(__func__) + "> Hdf5 filter " + to_string(m_filter) + " is not available.");
+	}
+
+	const bool filtered = m_shuffle || m_deflate_level > 0 || m_filter != H5Z_FILTER_NONE;
+	if (m_chunk_size == 0 && filtered) {
+		throw runtime_error(string(__func__) + "> Compression needs a chunk size.");
+	}
+}
+
+DSetCreatPropList Hdf5Profile::getCreateList(hsize_t num_rows) const {
+	DSetCreatPropList plist;
+	if (m_chunk_size == 0 || num_rows == 0) {
+		return plist;
+	}
+	// A chunk cannot be larger than the (fixed size) dataset.
+	hsize_t chunk_dims[1] = {min(m_chunk_size, num_rows)};
+	plist.setChunk(1, chunk_dims);
+	if (m_shuffle) {
+		plist.setShuffle();
+	}
+	if (m_deflate_level > 0) {
+		plist.setDeflate(m_deflate_level);
+	}
+	if (m_filter != H5Z_FILTER_NONE) {
+		plist.setFilter(m_filter, H5Z_FLAG_MANDATORY, m_filter_params.size(), m_filter_params.data());
+	}
+	return plist;
+}
+
+}
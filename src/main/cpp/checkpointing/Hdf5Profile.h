@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ * @file
+ * Header file for the layout and filters of the datasets in a checkpoint file.
+ */
+
+#ifdef HDF5_USED
+
+#include "H5Cpp.h"
+
+#include <boost/property_tree/ptree.hpp>
+#include <vector>
+
+namespace stride {
+
+/**
+ * Chunk layout and compression of the large datasets (persons and clusters) in a checkpoint file.
+ * The filters are applied per chunk and undone by the library when reading, so loading needs no settings.
+ */
+class Hdf5Profile {
+public:
+	/// Chunks of 10000 rows, no filters.
+	Hdf5Profile();
+
+	/// Read from the attributes of <checkpointing>: chunk_size, compression ("none" or "deflate"),
+	/// compression_level, shuffle, and filter/filter_params for any other (registered) hdf5 filter.
+	explicit Hdf5Profile(const boost::property_tree::ptree& pt_checkpointing);
+
+	/// Creation properties of a dataset with the given number of rows.
+	H5::DSetCreatPropList getCreateList(hsize_t num_rows) const;
+
+private:
+	hsize_t m_chunk_size;               ///< Rows per chunk (0 means contiguous, which allows no filters).
+	bool m_shuffle;                     ///< Shuffle the bytes of the values before compressing them.
+	int m_deflate_level;                ///< Deflate (gzip) level, 0 means no deflate.
+	H5Z_filter_t m_filter;              ///< Another filter (H5Z_FILTER_NONE if none).
+	std::vector<unsigned int> m_filter_params;
+};
+
+}
+
+#endif
@@ -24,6 +24,11 @@
 #include "checkpointing/datatypes/PersonTIDataType.h"
 #include "checkpointing/datatypes/TravellerDataType.h"
 
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
 #include <vector>
 
 using namespace H5;
@@ -34,40 +39,82 @@ using std::ostringstream;
 
 namespace stride {
 
-Hdf5Saver::Hdf5Saver(string filename, const ptree& pt_config, int frequency, RunMode run_mode, int start_timestep)
-		: m_filename(filename), m_frequency(frequency),
-		  m_current_step(start_timestep - 1), m_timestep(start_timestep),
-		  m_save_count(0) {
+Hdf5Saver::Hdf5Saver(string filename, const ptree& pt_config, int frequency, RunMode run_mode, int start_timestep,
+					 bool background, unsigned int keyframe_interval)
+		: Hdf5Saver(filename, "", nullptr, pt_config, frequency, run_mode, start_timestep, background,
+					keyframe_interval) {}
+
+Hdf5Saver::Hdf5Saver(std::shared_ptr<Hdf5Writer> writer, const string& group, const ptree& pt_config, int frequency,
+					 RunMode run_mode, int start_timestep, unsigned int keyframe_interval)
+		: Hdf5Saver(writer->getFilename(), group, writer, pt_config, frequency, run_mode, start_timestep, true,
+					keyframe_interval) {}
+
+Hdf5Saver::Hdf5Saver(const string& filename, const string& group, std::shared_ptr<Hdf5Writer> writer,
+					 const ptree& pt_config, int frequency, RunMode run_mode, int start_timestep, bool background,
+					 unsigned int keyframe_interval)
+		: m_filename(filename), m_root(group.empty() ? "" : "/" + group), m_writer(writer),
+		  m_frequency(frequency), m_current_step(start_timestep - 1), m_timestep(start_timestep),
+		  m_save_count(0), m_profile(pt_config.get_child("run.outputs.checkpointing", ptree())),
+		  m_background(background), m_keyframe_interval(keyframe_interval),
+		  m_saves_since_keyframe(0), m_has_previous_snapshot(false),
+		  m_snapshots(make_unique<std::array<Snapshot, 2>>()), m_next_snapshot(0) {
 
 	// Check if the simulator is run in extend mode and not from timestep 0
-	if (start_timestep != 0 && run_mode == RunMode::Extend) {
-		// If the hdf5 file already exists, append the data, otherwise still run the whole constructor
-		if (exists(system_complete(string(filename)))) {
-
-			// Adjust the amount of saved timesteps
-			H5File file(m_filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT, H5P_DEFAULT);
-			DataSet dataset = DataSet(file.openDataSet("amt_timesteps"));
-			unsigned int data[1];
-			dataset.read(data, PredType::NATIVE_UINT);
-			dataset.close();
-			file.close();
-
-			m_save_count = data[0];
-			return;
-		}
+	const bool extend = start_timestep != 0 && run_mode == RunMode::Extend;
+
+	if (m_writer) {
+		// The file is shared, so only the writer touches it. Without extending, the group of a previous
+		// run (e.g. the one that was replayed) is replaced.
+		m_writer->submit([this, &pt_config, extend](H5File& file) {
+			if (H5Lexists(file.getId(), m_root.c_str(), H5P_DEFAULT) > 0) {
+				if (extend) {
+					this->initFile(file, pt_config, true);
+					return;
+				}
+				H5Ldelete(file.getId(), m_root.c_str(), H5P_DEFAULT);
+			}
+			file.createGroup(m_root).close();
+			this->initFile(file, pt_config, false);
+		}).get();
+		return;
 	}
-	try {
-		H5File file(m_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
 
-		this->saveConfigs(file, pt_config);
-		this->saveTimestepMetadata(file, 0, 0, true);
+	std::lock_guard<std::mutex> lock(Hdf5Writer::getLibraryMutex());
 
+	// If the hdf5 file already exists, append the data, otherwise still run the whole constructor
+	if (extend && exists(system_complete(string(filename)))) {
+		H5File file(m_filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT, H5P_DEFAULT);
+		this->initFile(file, pt_config, true);
+		file.close();
+		return;
+	}
+	try {
+		H5File file(m_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+		this->initFile(file, pt_config, false);
 		file.close();
 	} catch (FileIException error) {
 		error.printError();
 	}
 }
 
+void Hdf5Saver::initFile(H5File& file, const ptree& pt_config, bool extend) {
+	if (extend) {
+		// Adjust the amount of saved timesteps
+		DataSet dataset = DataSet(file.openDataSet(m_root + "/amt_timesteps"));
+		unsigned int data[1];
+		dataset.read(data, PredType::NATIVE_UINT);
+		dataset.close();
+		m_save_count = data[0];
+	} else {
+		this->saveConfigs(file, pt_config);
+		this->saveTimestepMetadata(file, m_root, 0, 0, true);
+	}
+}
+
+Hdf5Saver::~Hdf5Saver() {
+	flush();
+}
+
 void Hdf5Saver::update(const Simulator& sim) {
 	m_current_step++;
 	if (m_frequency != 0 && m_current_step % m_frequency == 0) {
@@ -84,38 +131,237 @@ void Hdf5Saver::forceSave(const Simulator& sim, int timestep) {
 	this->saveTimestep(sim);
 }
 
+void Hdf5Saver::flush() {
+	if (m_writing.valid()) {
+		m_writing.get();
+	}
+}
+
 
 void Hdf5Saver::saveTimestep(const Simulator& sim) {
-	try {
-		m_save_count++;
-		H5File file(m_filename.c_str(), H5F_ACC_RDWR);
+	m_save_count++;
+
+	// The previous checkpoint may still be written from the other buffer, wait for it before writing this one
+	// (at most one checkpoint in flight).
+	Snapshot& snapshot = (*m_snapshots)[m_next_snapshot];
+
+	// Every so many checkpoints (and the first one) is a keyframe, the others only hold the changes.
+	// The previous checkpoint is only read, so it may still be written in the meantime.
+	snapshot.m_is_keyframe = !m_has_previous_snapshot || m_keyframe_interval == 0
+							 || m_saves_since_keyframe + 1 >= m_keyframe_interval;
+	this->takeSnapshot(sim, snapshot);
+	if (snapshot.m_is_keyframe) {
+		m_saves_since_keyframe = 0;
+	} else {
+		takeDelta((*m_snapshots)[1 - m_next_snapshot], snapshot);
+		m_saves_since_keyframe++;
+	}
+	m_has_previous_snapshot = true;
+	m_next_snapshot = 1 - m_next_snapshot;
+	this->flush();
+
+	if (m_writer) {
+		m_writing = m_writer->submit(std::bind(&Hdf5Saver::writeSnapshot, std::placeholders::_1, m_root, m_profile,
+											   std::cref(snapshot)));
+	} else if (m_background) {
+		m_writing = std::async(std::launch::async, &Hdf5Saver::writeSnapshotToFile, m_filename, m_root, m_profile,
+							   std::cref(snapshot));
+	} else {
+		writeSnapshotToFile(m_filename, m_root, m_profile, snapshot);
+	}
+	m_timestep += m_frequency;
+}
+
 
-		if (m_current_step == 0) {
-			this->savePersonTIData(file, sim);
+void Hdf5Saver::takeSnapshot(const Simulator& sim, Snapshot& snapshot) const {
+	using PersonType = Simulator::PersonType;
+	const Population& population = *sim.getPopulation();
+	const std::vector<PersonType>& persons = population.m_original;
+
+	snapshot.m_timestep = m_timestep;
+	snapshot.m_current_step = m_current_step;
+	snapshot.m_save_count = m_save_count;
+
+	// The time independent person data is saved with the first step only.
+	snapshot.m_persons_ti.clear();
+	if (m_current_step == 0) {
+		snapshot.m_persons_ti.resize(persons.size());
+		for (unsigned int i = 0; i < persons.size(); i++) {
+			PersonTIDataType& data = snapshot.m_persons_ti[i];
+			const PersonType& person = persons[i];
+			data.m_id = person.m_id;
+			data.m_age = person.m_age;
+			data.m_gender = person.m_gender;
+			data.m_household_id = person.m_household_id;
+			data.m_school_id = person.m_school_id;
+			data.m_work_id = person.m_work_id;
+			data.m_prim_comm_id = person.m_primary_community_id;
+			data.m_sec_comm_id = person.m_secondary_community_id;
+			data.m_start_infectiousness = person.m_health.getStartInfectiousness();
+			data.m_start_symptomatic = person.m_health.getStartSymptomatic();
+			data.m_time_infectiousness =
+					person.m_health.getEndInfectiousness() - person.m_health.getStartInfectiousness();
+			data.m_time_symptomatic = person.m_health.getEndSymptomatic() - person.m_health.getStartSymptomatic();
 		}
+	}
+
+	snapshot.m_has_rng_state = sim.m_rng != nullptr;
+	if (snapshot.m_has_rng_state) {
 		stringstream ss;
-		ss << "/Timestep_" << std::setfill('0') << std::setw(6) << m_timestep;
-		Group group(file.createGroup(ss.str()));
+		ss << *sim.m_rng;
+		snapshot.m_rng_state = ss.str();
+	}
+
+	stringstream ss;
+	ss << sim.m_calendar->getYear() << "-" << sim.m_calendar->getMonth() << "-" << sim.m_calendar->getDay();
+	snapshot.m_date = ss.str();
+	snapshot.m_day = sim.m_calendar->getSimulationDay();
+
+	snapshot.m_persons_td.resize(persons.size());
+	for (unsigned int i = 0; i < persons.size(); i++) {
+		PersonTDDataType& data = snapshot.m_persons_td[i];
+		const PersonType& person = persons[i];
+		data.m_participant = person.m_is_participant;
+		data.m_health_status = (unsigned int) person.m_health.getHealthStatus();
+		data.m_disease_counter = population.getDiseaseCounter(i);
+		data.m_on_vacation = person.m_is_on_vacation;
+	}
 
+	// The travellers, in the order of the planner (days left, then position in the day).
+	// The destination index of a traveller is its position in that order, after the original persons.
+	snapshot.m_travellers.resize(sim.m_planner.size());
+	snapshot.m_traveller_sim_names.resize(sim.m_planner.size());
+	unsigned int current_index = 0;
+	unsigned int list_index = 0;
+	for (auto&& day : sim.m_planner.getAgenda()) {
+		for (auto&& person: *day) {
+			TravellerDataType& traveller = snapshot.m_travellers[current_index];
+			auto& sim_names = snapshot.m_traveller_sim_names[current_index];
+			sim_names = make_pair(person->getHomeSimulatorId(), person->getDestinationSimulatorId());
 
-		if (sim.m_rng != nullptr) {
-			saveRngState(group, sim);
+			traveller.m_days_left = list_index;
+			traveller.m_home_sim_name = sim_names.first.c_str();
+			traveller.m_dest_sim_name = sim_names.second.c_str();
+			traveller.m_home_sim_index = person->getHomeSimulatorIndex();
+			traveller.m_dest_sim_index = persons.size() + current_index;
+
+			const PersonType& original_person = person->getHomePerson();
+			#define setAttributeTraveller(attr_lhs, attr_rhs) traveller.attr_lhs = original_person.attr_rhs
+			setAttributeTraveller(m_orig_id, m_id);
+			setAttributeTraveller(m_age, m_age);
+			setAttributeTraveller(m_gender, m_gender);
+			setAttributeTraveller(m_orig_household_id, m_household_id);
+			setAttributeTraveller(m_orig_school_id, m_school_id);
+			setAttributeTraveller(m_orig_work_id, m_work_id);
+			setAttributeTraveller(m_orig_prim_comm_id, m_primary_community_id);
+			setAttributeTraveller(m_orig_sec_comm_id, m_secondary_community_id);
+			setAttributeTraveller(m_start_infectiousness, m_health.getStartInfectiousness());
+			setAttributeTraveller(m_start_symptomatic, m_health.getStartSymptomatic());
+			#undef setAttributeTraveller
+			traveller.m_time_infectiousness = original_person.m_health.getEndInfectiousness() -
+											  original_person.m_health.getStartInfectiousness();
+			traveller.m_time_symptomatic = original_person.m_health.getEndSymptomatic() -
+										   original_person.m_health.getStartSymptomatic();
+
+			const PersonType& current_person = *person->getNewPerson();
+			traveller.m_participant = current_person.m_is_participant;
+			traveller.m_health_status = (unsigned int) current_person.m_health.getHealthStatus();
+			traveller.m_disease_counter = population.getDiseaseCounter(population.getIndex(person->getNewPerson()));
+			traveller.m_new_id = current_person.m_id;
+			traveller.m_new_household_id = current_person.m_household_id;
+			traveller.m_new_school_id = current_person.m_school_id;
+			traveller.m_new_work_id = current_person.m_work_id;
+			traveller.m_new_prim_comm_id = current_person.m_primary_community_id;
+			traveller.m_new_sec_comm_id = current_person.m_secondary_community_id;
+			current_index++;
 		}
-		this->saveCalendar(group, sim);
-		this->savePersonTDData(group, sim);
+		list_index++;
+	}
+
+	// The order of the members (by id) in the clusters of every type, a delta does not need it.
+	for (unsigned int type = 0; type < numOfClusterTypes(); type++) {
+		const vector<Cluster>& clusters = sim.getClusters(static_cast<ClusterType>(type));
+		vector<unsigned int>& cluster_data = snapshot.m_clusters[type];
+		cluster_data.clear();
+		if (!snapshot.m_is_keyframe) {
+			continue;
+		}
+		for (const auto& cluster: clusters) {
+			for (const auto member: cluster.m_members) {
+				cluster_data.push_back(population.getPerson(member).m_id);
+			}
+		}
+	}
+}
 
-		this->saveTravellers(group, sim);
 
-		this->saveClusters(group, "household_clusters", sim.m_households);
-		this->saveClusters(group, "school_clusters", sim.m_school_clusters);
-		this->saveClusters(group, "work_clusters", sim.m_work_clusters);
-		this->saveClusters(group, "primary_community_clusters", sim.m_primary_community);
-		this->saveClusters(group, "secondary_community_clusters", sim.m_secondary_community);
+void Hdf5Saver::takeDelta(const Snapshot& previous, Snapshot& snapshot) {
+	snapshot.m_previous_timestep = previous.m_timestep;
+
+	// Persons whose health, disease counter, participation or vacation changed.
+	snapshot.m_changed_persons.clear();
+	snapshot.m_changed_persons_td.clear();
+	for (unsigned int i = 0; i < snapshot.m_persons_td.size(); i++) {
+		const PersonTDDataType& before = previous.m_persons_td[i];
+		const PersonTDDataType& after = snapshot.m_persons_td[i];
+		if (before.m_participant != after.m_participant || before.m_health_status != after.m_health_status
+			|| before.m_disease_counter != after.m_disease_counter || before.m_on_vacation != after.m_on_vacation) {
+			snapshot.m_changed_persons.push_back(i);
+			snapshot.m_changed_persons_td.push_back(after);
+		}
+	}
+
+	// The clusters are not saved: only travellers join or leave them, and those are in every checkpoint.
+	// The order of the members follows from their health (see Hdf5Loader::sortClusterMembers).
+}
 
 
-		this->saveTimestepMetadata(file, m_save_count, m_current_step);
-		m_timestep += m_frequency;
+void Hdf5Saver::writeSnapshotToFile(const string& filename, const string& root, const Hdf5Profile& profile,
+									const Snapshot& snapshot) {
+	std::lock_guard<std::mutex> lock(Hdf5Writer::getLibraryMutex());
+	try {
+		H5File file(filename.c_str(), H5F_ACC_RDWR);
+		writeSnapshot(file, root, profile, snapshot);
 		file.close();
+	} catch (FileIException& error) {
+		std::cout << "Trying to open file: " << filename << " but failed." << std::endl;
+		error.printError();
+	}
+}
+
+void Hdf5Saver::writeSnapshot(H5File& file, const string& root, const Hdf5Profile& profile,
+							  const Snapshot& snapshot) {
+	try {
+		if (snapshot.m_current_step == 0) {
+			savePersonTIData(file, root, snapshot, profile);
+		}
+		stringstream ss;
+		ss << root << "/Timestep_" << std::setfill('0') << std::setw(6) << snapshot.m_timestep;
+		Group group(file.createGroup(ss.str()));
+
+
+		if (snapshot.m_has_rng_state) {
+			saveRngState(group, snapshot);
+		}
+		saveCalendar(group, snapshot);
+		saveTravellers(group, snapshot);
+
+		const string cluster_names[] = {"household_clusters", "school_clusters", "work_clusters",
+										"primary_community_clusters", "secondary_community_clusters"};
+		if (snapshot.m_is_keyframe) {
+			savePersonTDData(group, snapshot.m_persons_td, profile);
+			for (unsigned int type = 0; type < numOfClusterTypes(); type++) {
+				saveClusters(group, cluster_names[type], snapshot.m_clusters[type], profile);
+			}
+		} else {
+			// A delta refers to the previous checkpoint, see Hdf5Loader::loadFromTimestep.
+			saveClusters(group, "previous_timestep", {snapshot.m_previous_timestep}, profile);
+			saveClusters(group, "changed_persons", snapshot.m_changed_persons, profile);
+			savePersonTDData(group, snapshot.m_changed_persons_td, profile);
+		}
+
+
+		saveTimestepMetadata(file, root, snapshot.m_save_count, snapshot.m_current_step);
 	} catch (GroupIException& error) {
 		error.printError();
 		return;
@@ -123,7 +369,6 @@ void Hdf5Saver::saveTimestep(const Simulator& sim) {
 		error.printError();
 		return;
 	} catch (FileIException& error) {
-		std::cout << "Trying to open file: " << m_filename << " but failed." << std::endl;
 		error.printError();
 		return;
 	} catch (DataSetIException& error) {
@@ -140,241 +385,78 @@ void Hdf5Saver::saveTimestep(const Simulator& sim) {
 	return;
 }
 
-void Hdf5Saver::saveClusters(Group& group, string dataset_name, const vector<Cluster>& clusters) const {
-	auto getAmtIds = [&]() {
-		unsigned int amt = 0;
-		for (unsigned int i = 0; i < clusters.size(); i++) amt += clusters.at(i).getSize();
-		return amt;
-	};
-	unsigned int amtIds = getAmtIds();
-
+void Hdf5Saver::saveClusters(Group& group, string dataset_name, const vector<unsigned int>& cluster_data,
+							 const Hdf5Profile& profile) {
 	const unsigned int ndims_clusters = 1;
-	hsize_t dims_clusters[ndims_clusters] {amtIds};
+	hsize_t dims_clusters[ndims_clusters] {cluster_data.size()};
 	DataSpace dataspace_clusters = DataSpace(ndims_clusters, dims_clusters);
 	DataSet dataset_clusters = DataSet(
-			group.createDataSet(H5std_string(dataset_name), PredType::NATIVE_UINT, dataspace_clusters));
+			group.createDataSet(H5std_string(dataset_name), PredType::NATIVE_UINT, dataspace_clusters,
+								profile.getCreateList(dims_clusters[0])));
 
-	auto cluster_data = make_unique<vector<unsigned int>>(amtIds);
-	unsigned int index = 0;
-	for (unsigned int i = 0; i < clusters.size(); i++) {
-		for (unsigned int j = 0; j < clusters.at(i).getSize(); j++) {
-			(*cluster_data)[index++] = clusters.at(i).m_members.at(j).first->m_id;
-		}
-	}
-	dataset_clusters.write(cluster_data->data(), PredType::NATIVE_UINT);
+	if (!cluster_data.empty())
+		dataset_clusters.write(cluster_data.data(), PredType::NATIVE_UINT);
 	dataspace_clusters.close();
 	dataset_clusters.close();
 }
 
 
-void Hdf5Saver::savePersonTIData(H5File& file, const Simulator& sim) const {
-	hsize_t dims[1] {sim.getPopulation().get()->m_original.size()};
+void Hdf5Saver::savePersonTIData(H5File& file, const string& root, const Snapshot& snapshot,
+								 const Hdf5Profile& profile) {
+	hsize_t dims[1] {snapshot.m_persons_ti.size()};
 	DataSpace dataspace = DataSpace(1, dims);
 
+	// The persons are in one buffer, the library splits them in chunks (see Hdf5Profile).
 	CompType type_person_TI = PersonTIDataType::getCompType();
-	DataSet dataset = DataSet(file.createDataSet("person_time_independent", type_person_TI, dataspace));
-
-	// Persons are saved per chunk
-	unsigned int person_index = 0;
-	hsize_t chunk_dims[1] = {40000};
-	while (person_index < dims[0]) {
-		hsize_t selected_dims[1];
-		if (person_index + chunk_dims[0] < dims[0]) {
-			selected_dims[0] = chunk_dims[0];
-		} else {
-			selected_dims[0] = dims[0] - person_index;
-		}
-
-		PersonTIDataType personData[selected_dims[0]];
-		for (unsigned int j = 0; j < selected_dims[0]; j++) {
-			#define setAttributePerson(attr_lhs, attr_rhs) personData[j].attr_lhs = sim.getPopulation().get()->m_original.at(person_index).attr_rhs
-			setAttributePerson(m_id, m_id);
-			setAttributePerson(m_age, m_age);
-			setAttributePerson(m_gender, m_gender);
-			setAttributePerson(m_household_id, m_household_id);
-			setAttributePerson(m_school_id, m_school_id);
-			setAttributePerson(m_work_id, m_work_id);
-			setAttributePerson(m_prim_comm_id, m_primary_community_id);
-			setAttributePerson(m_sec_comm_id, m_secondary_community_id);
-			setAttributePerson(m_start_infectiousness, m_health.getStartInfectiousness());
-			setAttributePerson(m_start_symptomatic, m_health.getStartSymptomatic());
-			personData[j].m_time_infectiousness =
-					sim.getPopulation().get()->m_original.at(person_index).m_health.getEndInfectiousness() -
-					sim.getPopulation().get()->m_original.at(person_index).m_health.getStartInfectiousness();
-			personData[j].m_time_symptomatic =
-					sim.getPopulation().get()->m_original.at(person_index).m_health.getEndSymptomatic() -
-					sim.getPopulation().get()->m_original.at(person_index).m_health.getStartSymptomatic();
-			person_index++;
-		}
-
-		// Select a hyperslab in the dataset.
-		DataSpace filespace = DataSpace(dataset.getSpace());
-		hsize_t offset[1] {person_index - selected_dims[0]};
-		filespace.selectHyperslab(H5S_SELECT_SET, selected_dims, offset);
-
-		// Define memory space.
-		DataSpace memspace = DataSpace(1, selected_dims, NULL);
+	DataSet dataset = DataSet(file.createDataSet(root + "/person_time_independent", type_person_TI, dataspace,
+												 profile.getCreateList(dims[0])));
+	if (dims[0] != 0)
+		dataset.write(snapshot.m_persons_ti.data(), type_person_TI);
 
-		// Write data to the selected portion of the dataset.
-		dataset.write(personData, type_person_TI, memspace, filespace);
-	}
-	#undef setAttributePerson
+	dataset.close();
+	dataspace.close();
 }
 
 
-void Hdf5Saver::savePersonTDData(Group& group, const Simulator& sim) const {
-	hsize_t dims[1] {sim.getPopulation().get()->m_original.size()};
-	CompType type_person_TD = PersonTDDataType::getCompType();
-	const unsigned int CHUNK_SIZE = 10000;
-
-	// Dataspace can fit all persons but is chunked in parts of 10000 persons
+void Hdf5Saver::savePersonTDData(Group& group, const vector<PersonTDDataType>& persons, const Hdf5Profile& profile) {
+	hsize_t dims[1] {persons.size()};
 	DataSpace dataspace = DataSpace(1, dims);
-	DSetCreatPropList plist = DSetCreatPropList();
-	hsize_t chunk_dims[1] = {CHUNK_SIZE};
-	plist.setChunk(1, chunk_dims);
 
-	DataSet dataset;
-	if (dims[0] > CHUNK_SIZE) {
-		dataset = DataSet(group.createDataSet("person_time_dependent", type_person_TD, dataspace, plist));
-	} else {
-		dataset = DataSet(group.createDataSet("person_time_dependent", type_person_TD, dataspace));
-	}
-
-	using PersonType = Simulator::PersonType;
-	const std::vector<PersonType>& population = sim.getPopulation()->m_original;
-
-
-	// Persons are saved per chunk
-	unsigned int person_index = 0;
-	while (person_index < dims[0]) {
-		hsize_t selected_dims[1];
-		if (person_index + chunk_dims[0] < dims[0]) {
-			selected_dims[0] = chunk_dims[0];
-		} else {
-			selected_dims[0] = dims[0] - person_index;
-		}
-
-		PersonTDDataType person_data[selected_dims[0]];
-		for (unsigned int j = 0; j < selected_dims[0]; j++) {
-			const PersonType& person = population[person_index];
-			person_data[j].m_participant = person.m_is_participant;
-			person_data[j].m_health_status = (unsigned int) person.m_health.getHealthStatus();
-			person_data[j].m_disease_counter = (unsigned int) person.m_health.getDiseaseCounter();
-			person_data[j].m_on_vacation = person.m_is_on_vacation;
-			person_index++;
-		}
-
-		// Select a hyperslab in the dataset.
-		DataSpace filespace = DataSpace(dataset.getSpace());
-		hsize_t offset[1] = {person_index - selected_dims[0]};
-		filespace.selectHyperslab(H5S_SELECT_SET, selected_dims, offset);
-
-		// Define memory space.
-		DataSpace memspace = DataSpace(1, selected_dims, NULL);
-
-		// Write data to the selected portion of the dataset.
-		dataset.write(person_data, type_person_TD, memspace, filespace);
-		memspace.close();
-		filespace.close();
-	}
+	// The persons are in one buffer, the library splits them in chunks (see Hdf5Profile).
+	CompType type_person_TD = PersonTDDataType::getCompType();
+	DataSet dataset = DataSet(group.createDataSet("person_time_dependent", type_person_TD, dataspace,
+												  profile.getCreateList(dims[0])));
+	if (dims[0] != 0)
+		dataset.write(persons.data(), type_person_TD);
 
 	dataset.close();
 	dataspace.close();
 }
 
 
-void Hdf5Saver::saveTravellers(Group& group, const Simulator& sim) const {
-
-	using PersonType = Simulator::PersonType;
-	using Block = SimplePlanner<Simulator::TravellerType>::Block;
-	using Agenda = SimplePlanner<Simulator::TravellerType>::Agenda;
-
-	const Agenda& travellers = sim.m_planner.getAgenda();
-	hsize_t dims[1] {sim.m_planner.size()};
+void Hdf5Saver::saveTravellers(Group& group, const Snapshot& snapshot) {
+	hsize_t dims[1] {snapshot.m_travellers.size()};
 	CompType type_traveller = TravellerDataType::getCompType();
 
 	DataSpace dataspace = DataSpace(1, dims);
 	DataSet dataset = DataSet(group.createDataSet("travellers", type_traveller, dataspace));
-	auto traveller_data = make_unique<std::vector<TravellerDataType>>(dims[0]);
-
-
-	// Obtain the travellers in a single vector, more convenient for index calculations
-	vector<Simulator::PersonType*> travellers_seq;
-	for (auto&& day : sim.m_planner.getAgenda()) {
-		for (auto&& traveller : *(day)) {
-			travellers_seq.push_back(traveller->getNewPerson());
-		}
-	}
-
-	unsigned int current_index = 0;
-	unsigned int list_index = 0;
-
-	vector<pair<string,string>> sim_names(travellers_seq.size());
-
-	for (auto&& day : travellers) {
-		const Block& current_day = *(day);
-		for (auto&& person: current_day) {
-			TravellerDataType traveller;
-
-			sim_names.at(current_index) = make_pair(person->getHomeSimulatorId(), person->getDestinationSimulatorId());
-
-			traveller.m_days_left = list_index;
-			traveller.m_home_sim_name = sim_names.at(current_index).first.c_str();
-			traveller.m_dest_sim_name = sim_names.at(current_index).second.c_str();
-			traveller.m_home_sim_index = person->getHomeSimulatorIndex();
-			traveller.m_dest_sim_index = sim.m_population->m_original.size() +
-										 (std::find(travellers_seq.begin(), travellers_seq.end(),
-													person->getNewPerson()) - travellers_seq.begin());
 
-			PersonType original_person = person->getHomePerson();
-			#define setAttributeTraveller(attr_lhs, attr_rhs) traveller.attr_lhs = original_person.attr_rhs
-			setAttributeTraveller(m_orig_id, m_id);
-			setAttributeTraveller(m_age, m_age);
-			setAttributeTraveller(m_gender, m_gender);
-			setAttributeTraveller(m_orig_household_id, m_household_id);
-			setAttributeTraveller(m_orig_school_id, m_school_id);
-			setAttributeTraveller(m_orig_work_id, m_work_id);
-			setAttributeTraveller(m_orig_prim_comm_id, m_primary_community_id);
-			setAttributeTraveller(m_orig_sec_comm_id, m_secondary_community_id);
-			setAttributeTraveller(m_start_infectiousness, m_health.getStartInfectiousness());
-			setAttributeTraveller(m_start_symptomatic, m_health.getStartSymptomatic());
-			traveller.m_time_infectiousness = original_person.m_health.getEndInfectiousness() -
-											  original_person.m_health.getStartInfectiousness();
-			traveller.m_time_symptomatic = original_person.m_health.getEndSymptomatic() -
-										   original_person.m_health.getStartSymptomatic();
-
-			PersonType current_person = *person->getNewPerson();
-			traveller.m_participant = current_person.m_is_participant;
-			traveller.m_health_status = (unsigned int) current_person.m_health.getHealthStatus();;
-			traveller.m_disease_counter = (unsigned int) current_person.m_health.getDiseaseCounter();;
-			traveller.m_new_id = current_person.m_id;
-			traveller.m_new_household_id = current_person.m_household_id;
-			traveller.m_new_school_id = current_person.m_school_id;
-			traveller.m_new_work_id = current_person.m_work_id;
-			traveller.m_new_prim_comm_id = current_person.m_primary_community_id;
-			traveller.m_new_sec_comm_id = current_person.m_secondary_community_id;
-
-			(*traveller_data)[current_index++] = traveller;
-		}
-		list_index++;
-	}
-	#undef setAttributeTraveller
-
-	if (sim.m_planner.size() != 0)
-		dataset.write(traveller_data->data(), TravellerDataType::getCompType());
+	if (dims[0] != 0)
+		dataset.write(snapshot.m_travellers.data(), type_traveller);
 	dataset.close();
 	dataspace.close();
 }
 
 
-void Hdf5Saver::saveTimestepMetadata(H5File& file, unsigned int total_amt, unsigned int current, bool create) const {
+void Hdf5Saver::saveTimestepMetadata(H5File& file, const string& root, unsigned int total_amt, unsigned int current,
+									 bool create) {
 	DataSet dataset_amt;
 	if (create == true) {
 		hsize_t dims[1] {1};
 		DataSpace dataspace = DataSpace(1, dims);
-		dataset_amt = file.createDataSet("amt_timesteps", PredType::NATIVE_UINT, dataspace);
+		dataset_amt = file.createDataSet(root + "/amt_timesteps", PredType::NATIVE_UINT, dataspace);
 	} else {
-		dataset_amt = file.openDataSet("amt_timesteps");
+		dataset_amt = file.openDataSet(root + "/amt_timesteps");
 	}
 	unsigned int amt_timesteps[1] {total_amt};
 	dataset_amt.write(amt_timesteps, PredType::NATIVE_UINT);
@@ -385,9 +467,9 @@ void Hdf5Saver::saveTimestepMetadata(H5File& file, unsigned int total_amt, unsig
 	if (create == true) {
 		hsize_t dims[1] {1};
 		DataSpace dataspace = DataSpace(1, dims);
-		dataset_last = file.createDataSet("last_timestep", PredType::NATIVE_UINT, dataspace);
+		dataset_last = file.createDataSet(root + "/last_timestep", PredType::NATIVE_UINT, dataspace);
 	} else {
-		dataset_last = file.openDataSet("last_timestep");
+		dataset_last = file.openDataSet(root + "/last_timestep");
 	}
 	unsigned int last_timestep[1] {current};
 	dataset_last.write(last_timestep, PredType::NATIVE_UINT);
@@ -395,15 +477,12 @@ void Hdf5Saver::saveTimestepMetadata(H5File& file, unsigned int total_amt, unsig
 }
 
 
-void Hdf5Saver::saveRngState(Group& group, const Simulator& sim) const {
+void Hdf5Saver::saveRngState(Group& group, const Snapshot& snapshot) {
 	hsize_t dims[1] {1};
 	DataSpace dataspace = DataSpace(1, dims);
 	DataSet dataset = DataSet(group.createDataSet("randomgen", StrType(0, H5T_VARIABLE), dataspace));
 
-	stringstream ss;
-	ss << *sim.m_rng;
-	string cppString = ss.str();
-	const char* rng_state[1] {cppString.c_str()};
+	const char* rng_state[1] {snapshot.m_rng_state.c_str()};
 
 	dataset.write(rng_state, StrType(0, H5T_VARIABLE));
 	dataset.close();
@@ -411,19 +490,15 @@ void Hdf5Saver::saveRngState(Group& group, const Simulator& sim) const {
 }
 
 
-void Hdf5Saver::saveCalendar(Group& group, const Simulator& sim) const {
+void Hdf5Saver::saveCalendar(Group& group, const Snapshot& snapshot) {
 	hsize_t dims[1] {1};
 	CompType typeCalendar = CalendarDataType::getCompType();
 	DataSpace dataspace = DataSpace(1, dims);
 	DataSet dataset = DataSet(group.createDataSet("calendar", typeCalendar, dataspace));
 
-	stringstream ss;
-	ss << sim.m_calendar->getYear() << "-" << sim.m_calendar->getMonth() << "-" << sim.m_calendar->getDay();
-	string save_date = ss.str();
-
 	CalendarDataType calendar[1];
-	calendar[0].m_day = sim.m_calendar->getSimulationDay();
-	calendar[0].m_date = save_date.c_str();
+	calendar[0].m_day = snapshot.m_day;
+	calendar[0].m_date = snapshot.m_date.c_str();
 	dataset.write(calendar, typeCalendar);
 
 	dataset.close();
@@ -433,7 +508,7 @@ void Hdf5Saver::saveCalendar(Group& group, const Simulator& sim) const {
 
 void Hdf5Saver::saveConfigs(H5File& file, const ptree& pt_config) const {
 	hsize_t dims[1] {1};
-	Group group(file.createGroup("/Configuration"));
+	Group group(file.createGroup(m_root + "/Configuration"));
 	DataSpace dataspace = DataSpace(1, dims);
 
 	CompType type_conf_data = ConfigDataType::getCompType();
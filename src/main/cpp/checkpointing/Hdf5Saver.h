@@ -9,15 +9,24 @@
 #ifdef HDF5_USED
 
 #include "H5Cpp.h"
+#include "checkpointing/Hdf5Profile.h"
+#include "checkpointing/datatypes/PersonTDDataType.h"
+#include "checkpointing/datatypes/PersonTIDataType.h"
+#include "checkpointing/datatypes/TravellerDataType.h"
 
 #endif
 
+#include "checkpointing/Hdf5Writer.h"
 #include "util/Observer.h"
 #include "sim/Simulator.h"
 #include "sim/SimulatorRunMode.h"
 #include "core/Cluster.h"
 #include <boost/property_tree/xml_parser.hpp>
+#include <array>
+#include <future>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 using std::vector;
@@ -34,8 +43,23 @@ namespace stride {
 class Hdf5Saver : public util::Observer<Simulator> {
 #ifdef HDF5_USED
 public:
+	/// With background set, the checkpoints are written by another thread while the simulation goes on.
+	/// With a keyframe interval, only every so many checkpoints is a full one (keyframe), the others only
+	/// hold the changes since the previous checkpoint (0 means every checkpoint is full).
+	/// The chunks and filters of the datasets are read from run.outputs.checkpointing (see Hdf5Profile).
 	Hdf5Saver(string filename, const ptree& pt_config, int frequency,
-			  RunMode run_mode = RunMode::Initial, int start_timestep = 0);
+			  RunMode run_mode = RunMode::Initial, int start_timestep = 0, bool background = false,
+			  unsigned int keyframe_interval = 0);
+
+	/// Saves into the group with the given name in the file of the writer, which is shared with the savers
+	/// of other simulators. The checkpoints are always written in the background (by the writer).
+	Hdf5Saver(std::shared_ptr<Hdf5Writer> writer, const string& group, const ptree& pt_config, int frequency,
+			  RunMode run_mode = RunMode::Initial, int start_timestep = 0, unsigned int keyframe_interval = 0);
+
+	Hdf5Saver(Hdf5Saver&&) = default;
+
+	/// Waits until the last checkpoint is written.
+	~Hdf5Saver();
 
 	/// Update function which is called by the subject.
 	virtual void update(const Simulator& sim);
@@ -43,51 +67,115 @@ public:
 	/// Forces a save to the hdf5 file, with an optional timestep argument which specifies a new timestep save index.
 	void forceSave(const Simulator& sim, int timestep = -1);
 
+	/// Waits until the checkpoint that is being written in the background (if any) is in the file.
+	void flush();
+
 private:
+	/// Copy of everything that is saved for one timestep, so the simulator can go on while it is written.
+	struct Snapshot {
+		unsigned int m_timestep;      ///< Index of the timestep group in the file.
+		int m_current_step;
+		unsigned int m_save_count;
+		bool m_is_keyframe;           ///< Full checkpoint, otherwise only the changes since the previous one.
+		unsigned int m_previous_timestep;
+		std::vector<PersonTIDataType> m_persons_ti;    ///< Only for the first step.
+		std::vector<PersonTDDataType> m_persons_td;
+		std::vector<TravellerDataType> m_travellers;   ///< Names point into m_traveller_sim_names.
+		std::vector<std::pair<string, string>> m_traveller_sim_names;
+		std::array<std::vector<unsigned int>, numOfClusterTypes()> m_clusters;   ///< Keyframe: person ids by cluster type.
+		std::vector<unsigned int> m_changed_persons;           ///< Delta: indices of the changed persons.
+		std::vector<PersonTDDataType> m_changed_persons_td;    ///< Delta: their time dependent data.
+		bool m_has_rng_state;
+		string m_rng_state;
+		std::size_t m_day;
+		string m_date;
+	};
+
+	Hdf5Saver(const string& filename, const string& group, std::shared_ptr<Hdf5Writer> writer,
+			  const ptree& pt_config, int frequency, RunMode run_mode, int start_timestep, bool background,
+			  unsigned int keyframe_interval);
+
+	/// Creates the configuration and metadata of the checkpoints, or picks up the saved count when extending.
+	void initFile(H5File& file, const ptree& pt_config, bool extend);
+
 	void saveTimestep(const Simulator& sim);
 
-	/// Save the order of persons for a cluster group.
-	void saveClusters(Group& group, string dataset_name, const vector<Cluster>& clusters) const;
+	/// Copy the state of the simulator into the snapshot (reusing its buffers).
+	void takeSnapshot(const Simulator& sim, Snapshot& snapshot) const;
+
+	/// Find what changed in the snapshot since the previous one (for a delta checkpoint).
+	static void takeDelta(const Snapshot& previous, Snapshot& snapshot);
+
+	/// Open the file and write the snapshot (the library is called by one thread at a time).
+	static void writeSnapshotToFile(const string& filename, const string& root, const Hdf5Profile& profile,
+									const Snapshot& snapshot);
+
+	/// Write the snapshot under the root group of the file.
+	static void writeSnapshot(H5File& file, const string& root, const Hdf5Profile& profile,
+							  const Snapshot& snapshot);
+
+	/// Save the order of persons for a cluster group (or any other list of numbers).
+	static void saveClusters(Group& group, string dataset_name, const vector<unsigned int>& cluster_data,
+							 const Hdf5Profile& profile);
 
 	/// Saves the time indepent person data.
-	void savePersonTIData(H5File& file, const Simulator& sim) const;
+	static void savePersonTIData(H5File& file, const string& root, const Snapshot& snapshot,
+								 const Hdf5Profile& profile);
 
-	/// Saves the time dependent person data.
-	void savePersonTDData(Group& group, const Simulator& sim) const;
+	/// Saves the time dependent person data (of all persons or of the changed ones).
+	static void savePersonTDData(Group& group, const vector<PersonTDDataType>& persons, const Hdf5Profile& profile);
 
 	/// Saves the travellers.
-	void saveTravellers(Group& group, const Simulator& sim) const;
+	static void saveTravellers(Group& group, const Snapshot& snapshot);
 
 	/// Saves the total amount of timesteps and current timestep (create will create the dataset first, otherwise open).
-	void saveTimestepMetadata(H5File& file, unsigned int total_amt, unsigned int current, bool create = false) const;
+	static void saveTimestepMetadata(H5File& file, const string& root, unsigned int total_amt, unsigned int current,
+									 bool create = false);
 
-	/// Saves the state of the rng (NOTE only used with unipar dummy implementation).
-	void saveRngState(Group& group, const Simulator& sim) const;
+	/// Saves the state of the rng (the streams of the cluster blocks are seeded from it each day).
+	static void saveRngState(Group& group, const Snapshot& snapshot);
 
 	/// Saves the calendar.
-	void saveCalendar(Group& group, const Simulator& sim) const;
+	static void saveCalendar(Group& group, const Snapshot& snapshot);
 
 	/// Save all the configuration files (indirectly via the 'main' config file).
 	void saveConfigs(H5File& file, const ptree& pt_config) const;
 
 private:
 	string m_filename;
+	string m_root;                          ///< Path of the group of the checkpoints ("" is the root of the file).
+	std::shared_ptr<Hdf5Writer> m_writer;   ///< Shared writer, if any.
 	int m_frequency;
 	int m_current_step;
 	unsigned int m_timestep;
 	unsigned int m_save_count;
+	Hdf5Profile m_profile;
+	bool m_background;
+	unsigned int m_keyframe_interval;
+	unsigned int m_saves_since_keyframe;
+	bool m_has_previous_snapshot;   ///< The other buffer holds the previous checkpoint.
+	std::unique_ptr<std::array<Snapshot, 2>> m_snapshots;  ///< One is being written, the other one is filled.
+	unsigned int m_next_snapshot;
+	std::future<void> m_writing;   ///< The checkpoint that is being written in the background.
 #endif
 #ifndef HDF5_USED
 	// These dummy headers are used as an interface for when no hdf5 is included, but everything still needs to compile.
 	public:
 		Hdf5Saver(string filename, const ptree& pt_config, int frequency,
-			  RunMode run_mode = RunMode::Initial, int start_timestep = 0) {}
+			  RunMode run_mode = RunMode::Initial, int start_timestep = 0, bool background = false,
+			  unsigned int keyframe_interval = 0) {}
+
+		Hdf5Saver(std::shared_ptr<Hdf5Writer> writer, const string& group, const ptree& pt_config, int frequency,
+			  RunMode run_mode = RunMode::Initial, int start_timestep = 0, unsigned int keyframe_interval = 0) {}
 
 		/// Update function which is called by the subject.
 		virtual void update(const Simulator& sim) {}
 
 		/// Forces a save to the hdf5 file, with an optional timestep argument which specifies a new timestep save index.
 		void forceSave(const Simulator& sim, int timestep = -1) {}
+
+		/// Waits until the checkpoint that is being written in the background (if any) is in the file.
+		void flush() {}
 #endif
 };
 
@@ -0,0 +1,96 @@
+/**
+ * @file
+ * Source file for the writer thread that is shared by the checkpoints of several simulators.
+ */
+
+#include "Hdf5Writer.h"
+
+#include <boost/filesystem.hpp>
+#include <exception>
+#include <utility>
+
+using namespace H5;
+using namespace std;
+
+namespace stride {
+
+Hdf5Writer::Hdf5Writer(const string& filename, bool append)
+		: m_filename(filename), m_stop(false) {
+	{
+		lock_guard<mutex> lock(getLibraryMutex());
+		if (!append || !boost::filesystem::exists(boost::filesystem::system_complete(m_filename))) {
+			H5File file(m_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+			file.close();
+		}
+	}
+	m_thread = thread(&Hdf5Writer::writeJobs, this);
+}
+
+Hdf5Writer::~Hdf5Writer() {
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+future<void> Hdf5Writer::submit(Job job) {
+	Task task;
+	task.m_job = std::move(job);
+	future<void> done = task.m_done.get_future();
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_wake.notify_one();
+	return done;
+}
+
+void Hdf5Writer::flush() {
+	submit([](H5File&) {}).get();
+}
+
+mutex& Hdf5Writer::getLibraryMutex() {
+	static mutex library_mutex;
+	return library_mutex;
+}
+
+void Hdf5Writer::writeJobs() {
+	while (true) {
+		deque<Task> tasks;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+			if (m_tasks.empty()) {
+				return;
+			}
+			tasks.swap(m_tasks);
+		}
+
+		// All the jobs that are waiting go into the file in one go.
+		lock_guard<mutex> lock(getLibraryMutex());
+		try {
+			H5File file(m_filename.c_str(), H5F_ACC_RDWR);
+			for (auto& task: tasks) {
+				try {
+					task.m_job(file);
+					task.m_done.set_value();
+				} catch (...) {
+					task.m_done.set_exception(current_exception());
+				}
+			}
+			file.close();
+		} catch (...) {
+			// The file could not be opened (the jobs that are done already have their result).
+			for (auto& task: tasks) {
+				try {
+					task.m_done.set_exception(current_exception());
+				} catch (future_error&) {
+				}
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * @file
+ * Header file for the writer thread that is shared by the checkpoints of several simulators.
+ */
+
+#ifdef HDF5_USED
+
+#include "H5Cpp.h"
+
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace stride {
+
+/**
+ * Writes the checkpoints of several simulators (regions) into one file, each in its own group.
+ * The simulators hand their jobs to this writer and go on: one thread does all the hdf5 calls,
+ * so the simulators never wait on each other's writes. The jobs that are waiting when the thread
+ * gets to them (e.g. the checkpoints of all regions for a day) are written with the file opened once.
+ */
+class Hdf5Writer {
+#ifdef HDF5_USED
+public:
+	using Job = std::function<void(H5::H5File&)>;
+
+	/// Creates the file, unless append is set and the file already exists.
+	Hdf5Writer(const std::string& filename, bool append);
+
+	/// Writes the jobs that are still waiting.
+	~Hdf5Writer();
+
+	Hdf5Writer(const Hdf5Writer&) = delete;
+	Hdf5Writer& operator=(const Hdf5Writer&) = delete;
+
+	/// Queue the job, the future is ready (or holds the exception of the job) once it is done.
+	std::future<void> submit(Job job);
+
+	/// Waits until every job that was submitted before is done.
+	void flush();
+
+	const std::string& getFilename() const { return m_filename; }
+
+	/// The hdf5 library may not be thread safe, everything that calls it from several threads locks this.
+	static std::mutex& getLibraryMutex();
+
+private:
+	struct Task {
+		Job m_job;
+		std::promise<void> m_done;
+	};
+
+	/// Body of the writer thread.
+	void writeJobs();
+
+private:
+	std::string m_filename;
+	std::mutex m_mutex;                 ///< Guards the queue and m_stop.
+	std::condition_variable m_wake;
+	std::deque<Task> m_tasks;
+	bool m_stop;
+	std::thread m_thread;
+#endif
+#ifndef HDF5_USED
+	// These dummy headers are used as an interface for when no hdf5 is included, but everything still needs to compile.
+	public:
+		Hdf5Writer(const std::string& filename, bool append) {}
+
+		/// Waits until every job that was submitted before is done.
+		void flush() {}
+#endif
+};
+
+}
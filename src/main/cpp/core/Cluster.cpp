@@ -22,18 +22,23 @@
 
 #include "Infector.h"
 #include "calendar/Calendar.h"
+#include "util/Random.h"
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace stride {
 
 using namespace std;
 
 std::array<ContactProfile, numOfClusterTypes()> Cluster::g_profiles;
 
-Cluster::Cluster(std::size_t cluster_id, ClusterType cluster_type, GeoCoordinate coordinate)
+Cluster::Cluster(std::size_t cluster_id, ClusterType cluster_type, Population* population, GeoCoordinate coordinate)
 		: m_cluster_id(cluster_id), m_cluster_type(cluster_type),
-		  m_index_immune(0), m_profile(g_profiles.at(toSizeType(m_cluster_type))),
+		  m_index_immune(0), m_population(population), m_contact_probabilities(nullptr),
+		  m_profile(g_profiles.at(toSizeType(m_cluster_type))),
 		  m_coordinate(coordinate) {
 }
 
@@ -41,27 +46,42 @@ void Cluster::addContactProfile(ClusterType cluster_type, const ContactProfile&
 	g_profiles.at(toSizeType(cluster_type)) = profile;
 }
 
+void Cluster::setContactProbabilities(ContactProbabilityTable& table, double transmission_rate) {
+	const size_t size = m_members.size();
+	auto it = table.find(size);
+	if (it == table.end()) {
+		it = table.emplace(size, ContactProbabilities()).first;
+		for (size_t age = 0; age <= maximumAge(); age++) {
+			it->second.contact[age] = rateToProbability(m_profile[age] / size);
+			it->second.transmission[age] = rateToProbability(transmission_rate * (m_profile[age] / size));
+		}
+	}
+	m_contact_probabilities = &it->second;
+}
 
-void Cluster::addPerson(Simulator::PersonType* p) {
-	m_members.emplace_back(std::make_pair(p, true));
+
+void Cluster::addPerson(PersonIndex index) {
+	m_members.emplace_back(index);
 	m_index_immune++;
+	m_contact_probabilities = nullptr;
 }
 
 std::size_t Cluster::getInfectedCount() const {
 	size_t num_cases = 0;
 	for (auto& member : m_members) {
-		auto health = member.first->getHealth();
+		const auto& health = m_population->getPerson(member).getHealth();
 		if (health.isInfected() || health.isRecovered())
 			++num_cases;
 	}
 	return num_cases;
 }
 
-void Cluster::removePerson(unsigned int id) {
+void Cluster::removePerson(PersonIndex index) {
 	for (unsigned int i_member = 0; i_member < m_members.size(); ++i_member) {
-		if (m_members.at(i_member).first->getId() == id) {
+		if (m_members.at(i_member) == index) {
 			m_members.erase(m_members.begin() + i_member);
-			m_index_immune = m_members.size() > 0 ? m_members.size() - 1 : 0;
+			m_contact_probabilities = nullptr;
+			m_index_immune = m_members.size();
 			return;
 		}
 	}
@@ -69,8 +89,8 @@ void Cluster::removePerson(unsigned int id) {
 
 std::size_t Cluster::getActiveClusterMembers() const {
 	std::size_t total = 0;
-	for (const auto& person: m_members) {
-		if (!person.first->isOnVacation()) {
+	for (const auto& member: m_members) {
+		if (!m_population->getPerson(member).isOnVacation()) {
 			++total;
 		}
 	}
@@ -79,43 +99,53 @@ std::size_t Cluster::getActiveClusterMembers() const {
 }
 
 tuple<bool, size_t> Cluster::sortMembers() {
+	const auto& pop = *m_population;
+
+	// The members are ordered by group (exposed/infected/recovered, susceptible, immune) and by
+	// index within a group. The order then only depends on the health of the members today, not
+	// on the days the cluster was sorted before (see Simulator::updateHotClusters). The immune
+	// stay immune, so only the members in front of them are looked at.
+	const auto key = [&pop](PersonIndex index) {
+		const auto status = pop.getHealthStatus(index);
+		const uint64_t group = status == HealthStatus::Immune ? 2U : (status == HealthStatus::Susceptible ? 1U : 0U);
+		return (group << 32U) | index;
+	};
+	bool sorted = true;
+	for (size_t i_member = 1; i_member < m_index_immune && sorted; i_member++) {
+		sorted = key(m_members[i_member - 1]) < key(m_members[i_member]);
+	}
+	if (!sorted) {
+		vector<uint64_t> keys(m_index_immune);
+		for (size_t i_member = 0; i_member < m_index_immune; i_member++) {
+			keys[i_member] = key(m_members[i_member]);
+		}
+		sort(keys.begin(), keys.end());
+		for (size_t i_member = 0; i_member < m_index_immune; i_member++) {
+			m_members[i_member] = static_cast<PersonIndex>(keys[i_member]);
+		}
+	}
+
 	bool infectious_cases = false;
 	size_t num_cases = 0;
-
-	for (size_t i_member = 0; i_member < m_index_immune; i_member++) {
-		// if immune, move to back
-		if (m_members[i_member].first->getHealth().isImmune()) {
-			bool swapped = false;
-			size_t new_place = m_index_immune - 1;
-			m_index_immune--;
-			while (!swapped && new_place > i_member) {
-				if (m_members[new_place].first->getHealth().isImmune()) {
-					m_index_immune--;
-					new_place--;
-				} else {
-					swap(m_members[i_member], m_members[new_place]);
-					swapped = true;
-				}
-			}
-		}
-			// else, if not susceptible, move to front
-		else if (!m_members[i_member].first->getHealth().isSusceptible()) {
-			if (!infectious_cases && m_members[i_member].first->getHealth().isInfectious()) {
-				infectious_cases = true;
-			}
-			if (i_member > num_cases) {
-				swap(m_members[i_member], m_members[num_cases]);
-			}
-			num_cases++;
+	while (num_cases < m_index_immune) {
+		const auto status = pop.getHealthStatus(m_members[num_cases]);
+		if (status == HealthStatus::Immune || status == HealthStatus::Susceptible) {
+			break;
 		}
+		infectious_cases = infectious_cases || Health::isInfectious(status);
+		num_cases++;
+	}
+	while (m_index_immune > num_cases && pop.getHealthStatus(m_members[m_index_immune - 1]) == HealthStatus::Immune) {
+		m_index_immune--;
 	}
 	return make_tuple(infectious_cases, num_cases);
 }
 
-void Cluster::updateMemberPresence() {
-	for (auto& member: m_members) {
-		member.second = member.first->isInCluster(m_cluster_type);
-	}
+array<bool, 3> Cluster::presentClasses() const {
+	// Presence is looked up by class, so the members may be reordered (see sortMembers) and need no state.
+	const auto& masks = m_population->getPresenceMasks();
+	const unsigned char bit = 1U << toSizeType(m_cluster_type);
+	return {{(masks[0] & bit) != 0U, (masks[1] & bit) != 0U, (masks[2] & bit) != 0U}};
 }
 
 }
@@ -20,9 +20,12 @@
  */
 
 #include "core/ClusterType.h"
+#include "core/ContactProbabilities.h"
 #include "core/ContactProfile.h"
 #include "core/LogMode.h"
+#include "pop/Age.h"
 #include "pop/Person.h"
+#include "pop/Population.h"
 #include "pop/PopulationBuilder.h"
 #include "sim/Simulator.h"
 #include "util/GeoCoordinate.h"
@@ -46,13 +49,17 @@ class Calendar;
 class Cluster {
 public:
 	/// Constructor
-	Cluster(std::size_t cluster_id, ClusterType cluster_type, GeoCoordinate coordinate = GeoCoordinate(0, 0));
+	Cluster(std::size_t cluster_id, ClusterType cluster_type, Population* population,
+			GeoCoordinate coordinate = GeoCoordinate(0, 0));
 
-	/// Add the given Person to the Cluster.
-	void addPerson(Simulator::PersonType* p);
+	/// Add the Person with the given index in the population to the Cluster.
+	void addPerson(PersonIndex index);
 
-	/// Remove the given Person from the Cluster.
-	void removePerson(unsigned int id);
+	/// Make room for the given number of members (when that number is known in advance).
+	void reserveMembers(std::size_t num_members) { m_members.reserve(num_members); }
+
+	/// Remove the Person with the given index in the population from the Cluster.
+	void removePerson(PersonIndex index);
 
 	/// Return number of persons in this cluster.
 	std::size_t getSize() const { return m_members.size(); }
@@ -69,17 +76,34 @@ public:
 	/// Return the geo coordinates (latitude-longitude) of the cluster
 	GeoCoordinate getLocation() const { return m_coordinate; }
 
-	/// Get basic contact rate in this cluster.
-	double getContactRate(const Simulator::PersonType* p) const {
-		return g_profiles.at(toSizeType(m_cluster_type))[effectiveAge(p->getAge())] / m_members.size();;
+	/// Get basic contact rate in this cluster for a member of the given effective age.
+	double getContactRate(unsigned int effective_age) const {
+		return g_profiles.at(toSizeType(m_cluster_type))[effective_age] / m_members.size();
+	}
+
+	/// Get the probability of contact in this cluster for a member of the given effective age.
+	double getContactProbability(unsigned int effective_age) const {
+		return m_contact_probabilities->contact[effective_age];
 	}
 
+	/// Get the probability of contact and transmission (in one draw) for a member of the given effective age.
+	double getTransmissionProbability(unsigned int effective_age) const {
+		return m_contact_probabilities->transmission[effective_age];
+	}
+
+	/// Look up the contact probabilities for the current size in the table (with the probabilities of the
+	/// clusters of this type), adding them if needed. Has to be done after every change in membership.
+	void setContactProbabilities(ContactProbabilityTable& table, double transmission_rate);
+
 	/// Get the ID of this cluster
 	std::size_t getId() const { return m_cluster_id; }
 
-	/// Get the members of this vector
+	/// Get the members of this cluster (index in the population).
 	/// Rather for testing purposes
-	const std::vector<std::pair<Simulator::PersonType*, bool>>& getMembers() const { return m_members; }
+	const std::vector<PersonIndex>& getMembers() const { return m_members; }
+
+	/// Get the population the members belong to.
+	const Population& getPopulation() const { return *m_population; }
 
 public:
 	/// Add contact profile.
@@ -94,14 +118,16 @@ private:
 	friend
 	class Infector;
 
-	/// Calculate which members are present in the cluster on the current day.
-	void updateMemberPresence();
+	/// Which presence classes (see Population::getPresenceClasses) are in a cluster of this type today.
+	std::array<bool, 3> presentClasses() const;
 
 private:
 	std::size_t m_cluster_id;     ///< The ID of the Cluster (for logging purposes).
 	ClusterType m_cluster_type;   ///< The type of the Cluster (for logging purposes).
 	std::size_t m_index_immune;   ///< Index of the first immune member in the Cluster.
-	std::vector<std::pair<Simulator::PersonType*, bool>> m_members;  ///< Container with pointers to Cluster members.
+	std::vector<PersonIndex> m_members;  ///< Container with indices of Cluster members.
+	Population* m_population;     ///< The population the members belong to.
+	const ContactProbabilities* m_contact_probabilities;  ///< Contact probabilities (nullptr if membership changed).
 	const ContactProfile& m_profile;
 	const GeoCoordinate m_coordinate;    ///< The location of the cluster
 private:
@@ -0,0 +1,64 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Implementation of ClusterScheduling.
+ */
+
+#include "ClusterScheduling.h"
+
+#include <boost/algorithm/string.hpp>
+#include <map>
+
+namespace {
+
+using stride::ClusterScheduling;
+using boost::to_upper;
+using namespace std;
+
+map<ClusterScheduling, string> g_cluster_scheduling_name {
+		make_pair(ClusterScheduling::PerType, "PerType"),
+		make_pair(ClusterScheduling::Balanced, "Balanced"),
+		make_pair(ClusterScheduling::Null, "Null")
+};
+
+map<string, ClusterScheduling> g_name_cluster_scheduling {
+		make_pair("PERTYPE", ClusterScheduling::PerType),
+		make_pair("BALANCED", ClusterScheduling::Balanced),
+		make_pair("NULL", ClusterScheduling::Null)
+};
+
+}
+
+namespace stride {
+
+string toString(ClusterScheduling s) {
+	return (g_cluster_scheduling_name.count(s) == 1) ? g_cluster_scheduling_name[s] : "Null";
+}
+
+bool isClusterScheduling(const string& s) {
+	std::string t {s};
+	to_upper(t);
+	return (g_name_cluster_scheduling.count(t) == 1);
+}
+
+ClusterScheduling toClusterScheduling(const string& s) {
+	std::string t {s};
+	to_upper(t);
+	return (g_name_cluster_scheduling.count(t) == 1) ? g_name_cluster_scheduling[t] : ClusterScheduling::Null;
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Header for the ClusterScheduling class.
+ */
+
+#include <string>
+
+namespace stride {
+
+/**
+* Enum specifiying how the clusters are divided over the threads every day:
+* \li one parallel loop per cluster type, the clusters in fixed-size blocks
+* \li one parallel loop over all types, the clusters binned into tasks of similar cost.
+*/
+enum class ClusterScheduling {
+	PerType = 0U, Balanced = 1U, Null
+};
+
+/// Converts a ClusterScheduling value to corresponding name.
+std::string toString(ClusterScheduling s);
+
+/// Check whether string is name of ClusterScheduling value.
+bool isClusterScheduling(const std::string& s);
+
+/// Converts a string with name to ClusterScheduling value.
+ClusterScheduling toClusterScheduling(const std::string& s);
+
+}
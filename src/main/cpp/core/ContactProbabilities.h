@@ -0,0 +1,39 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Contact probabilities in the clusters.
+ */
+
+#include "pop/Age.h"
+
+#include <array>
+#include <cstddef>
+#include <map>
+
+namespace stride {
+
+/// Probabilities in a cluster of a given type and size, by effective age of the member.
+struct ContactProbabilities {
+	std::array<double, maximumAge() + 1> contact;       ///< Of contact with another member.
+	std::array<double, maximumAge() + 1> transmission;  ///< Of contact with another member and transmission, in one draw.
+};
+
+/// Contact probabilities of the clusters of one type, by size. The entries stay in place, so clusters keep a pointer.
+using ContactProbabilityTable = std::map<std::size_t, ContactProbabilities>;
+
+}
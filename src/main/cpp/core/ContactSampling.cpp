@@ -0,0 +1,64 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Implementation of ContactSampling.
+ */
+
+#include "ContactSampling.h"
+
+#include <boost/algorithm/string.hpp>
+#include <map>
+
+namespace {
+
+using stride::ContactSampling;
+using boost::to_upper;
+using namespace std;
+
+map<ContactSampling, string> g_contact_sampling_name {
+		make_pair(ContactSampling::Pairwise, "Pairwise"),
+		make_pair(ContactSampling::Geometric, "Geometric"),
+		make_pair(ContactSampling::Null, "Null")
+};
+
+map<string, ContactSampling> g_name_contact_sampling {
+		make_pair("PAIRWISE", ContactSampling::Pairwise),
+		make_pair("GEOMETRIC", ContactSampling::Geometric),
+		make_pair("NULL", ContactSampling::Null)
+};
+
+}
+
+namespace stride {
+
+string toString(ContactSampling s) {
+	return (g_contact_sampling_name.count(s) == 1) ? g_contact_sampling_name[s] : "Null";
+}
+
+bool isContactSampling(const string& s) {
+	std::string t {s};
+	to_upper(t);
+	return (g_name_contact_sampling.count(t) == 1);
+}
+
+ContactSampling toContactSampling(const string& s) {
+	std::string t {s};
+	to_upper(t);
+	return (g_name_contact_sampling.count(t) == 1) ? g_name_contact_sampling[t] : ContactSampling::Null;
+}
+
+}
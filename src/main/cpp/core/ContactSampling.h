@@ -0,0 +1,44 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Header for the ContactSampling class.
+ */
+
+#include <string>
+
+namespace stride {
+
+/**
+* Enum specifiying how contacts with transmission are sampled in a cluster:
+* \li one random draw per (infectious, susceptible) pair
+* \li draw the gap to the next successful pair from a geometric distribution.
+*/
+enum class ContactSampling {
+	Pairwise = 0U, Geometric = 1U, Null
+};
+
+/// Converts a ContactSampling value to corresponding name.
+std::string toString(ContactSampling s);
+
+/// Check whether string is name of ContactSampling value.
+bool isContactSampling(const std::string& s);
+
+/// Converts a string with name to ContactSampling value.
+ContactSampling toContactSampling(const std::string& s);
+
+}
@@ -16,6 +16,7 @@
 #include "Health.h"
 
 #include <assert.h>
+#include <initializer_list>
 
 namespace stride {
 
@@ -51,6 +52,19 @@ void Health::stopInfection() {
 	m_status = HealthStatus::Recovered;
 }
 
+unsigned int Health::getDaysToNextTransition() const {
+	if (!isInfected()) {
+		return 0U;
+	}
+	unsigned int next = 0U;
+	for (const auto day: {m_start_infectiousness, m_end_infectiousness, m_start_symptomatic, m_end_symptomatic}) {
+		if (day > m_disease_counter && (next == 0U || day < next)) {
+			next = day;
+		}
+	}
+	return next == 0U ? 0U : next - m_disease_counter;
+}
+
 void Health::update() {
 	const bool infected = m_status == HealthStatus::Exposed
 						  || m_status == HealthStatus::Infectious
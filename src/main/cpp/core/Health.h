@@ -16,7 +16,8 @@
 
 namespace stride {
 
-enum class HealthStatus {
+/// Health states; a single byte so it can be stored per person in the Population columns.
+enum class HealthStatus : unsigned char {
 	Susceptible = 0U, Exposed = 1U, Infectious = 2U,
 	Symptomatic = 3U, InfectiousAndSymptomatic = 4U, Recovered = 5U, Immune = 6U, Null
 };
@@ -47,17 +48,23 @@ public:
 	bool isImmune() const { return m_status == HealthStatus::Immune; }
 
 	///
-	bool isInfected() const {
-		return m_status == HealthStatus::Exposed
-			   || m_status == HealthStatus::Infectious
-			   || m_status == HealthStatus::InfectiousAndSymptomatic
-			   || m_status == HealthStatus::Symptomatic;
+	bool isInfected() const { return isInfected(m_status); }
+
+	/// Is a person with the given status infected?
+	static bool isInfected(HealthStatus status) {
+		return status == HealthStatus::Exposed
+			   || status == HealthStatus::Infectious
+			   || status == HealthStatus::InfectiousAndSymptomatic
+			   || status == HealthStatus::Symptomatic;
 	}
 
 	///
-	bool isInfectious() const {
-		return m_status == HealthStatus::Infectious
-			   || m_status == HealthStatus::InfectiousAndSymptomatic;
+	bool isInfectious() const { return isInfectious(m_status); }
+
+	/// Is a person with the given status infectious?
+	static bool isInfectious(HealthStatus status) {
+		return status == HealthStatus::Infectious
+			   || status == HealthStatus::InfectiousAndSymptomatic;
 	}
 
 	///
@@ -84,10 +91,16 @@ public:
 	/// Update progress of the disease.
 	void update();
 
-private:
 	/// Get the disease counter.
 	unsigned int getDiseaseCounter() const { return m_disease_counter; }
 
+	/// Number of updates until the next one that may change the status (0 if there is none).
+	unsigned int getDaysToNextTransition() const;
+
+	/// Advance the disease counter without changing the status (see getDaysToNextTransition).
+	void advanceDiseaseCounter(unsigned int days) { m_disease_counter += days; }
+
+private:
 	/// Increment disease counter.
 	void incrementDiseaseCounter() { m_disease_counter++; }
 
@@ -24,6 +24,7 @@
 #include "core/Infector.h"
 #include "core/LogMode.h"
 #include "pop/Person.h"
+#include "pop/Population.h"
 #include "util/Random.h"
 
 #include <spdlog/spdlog.h>
@@ -43,7 +44,7 @@ using namespace util;
 template<bool track_index_case = false>
 class R0_POLICY {
 public:
-	static void execute(Simulator::PersonType* p) {}
+	static void execute(Population& pop, PersonIndex p) {}
 };
 
 /**
@@ -52,7 +53,7 @@ public:
 template<>
 class R0_POLICY<true> {
 public:
-	static void execute(Simulator::PersonType* p) { p->getHealth().stopInfection(); }
+	static void execute(Population& pop, PersonIndex p) { pop.stopInfection(p); }
 };
 
 /**
@@ -61,7 +62,7 @@ public:
 template<LogMode log_level = LogMode::None>
 class LOG_POLICY {
 public:
-	static void execute(spdlog::logger& logger, Simulator::PersonType* p1, Simulator::PersonType* p2,
+	static void execute(spdlog::logger& logger, const Population& pop, PersonIndex p1, PersonIndex p2,
 						ClusterType cluster_type, shared_ptr<const Calendar> environ) {}
 };
 
@@ -71,10 +72,11 @@ public:
 template<>
 class LOG_POLICY<LogMode::Transmissions> {
 public:
-	static void execute(spdlog::logger& logger, Simulator::PersonType* p1, Simulator::PersonType* p2,
+	static void execute(spdlog::logger& logger, const Population& pop, PersonIndex p1, PersonIndex p2,
 						ClusterType cluster_type, shared_ptr<const Calendar> environ) {
 		logger.info("[TRAN] {} {} {} {}",
-					p1->getId(), p2->getId(), toString(cluster_type), environ->getSimulationDay());
+					pop.getPerson(p1).getId(), pop.getPerson(p2).getId(), toString(cluster_type),
+					environ->getSimulationDay());
 	}
 };
 
@@ -84,8 +86,10 @@ public:
 template<>
 class LOG_POLICY<LogMode::Contacts> {
 public:
-	static void execute(spdlog::logger& logger, Simulator::PersonType* p1, Simulator::PersonType* p2,
+	static void execute(spdlog::logger& logger, const Population& pop, PersonIndex p1, PersonIndex p2,
 						ClusterType cluster_type, shared_ptr<const Calendar> calendar) {
+		const auto& person1 = pop.getPerson(p1);
+		const auto& person2 = pop.getPerson(p2);
 		unsigned int home = (cluster_type == ClusterType::Household);
 		unsigned int work = (cluster_type == ClusterType::Work);
 		unsigned int school = (cluster_type == ClusterType::School);
@@ -93,7 +97,7 @@ public:
 		unsigned int secundary_community = (cluster_type == ClusterType::SecondaryCommunity);
 
 		logger.info("[CONT] {} {} {} {} {} {} {} {} {}",
-					p1->getId(), p1->getAge(), p2->getAge(), home, school, work, primary_community,
+					person1.getId(), person1.getAge(), person2.getAge(), home, school, work, primary_community,
 					secundary_community,
 					calendar->getSimulationDay());
 	}
@@ -108,43 +112,47 @@ public:
 template<LogMode log_level, bool track_index_case, typename local_information_policy>
 void Infector<log_level, track_index_case, local_information_policy>::execute(
 		Cluster& cluster, DiseaseProfile disease_profile,
-		util::Random& contact_handler, shared_ptr<const Calendar> calendar, spdlog::logger& logger) {
-	cluster.updateMemberPresence();
-
+		util::Random& contact_handler, shared_ptr<const Calendar> calendar, spdlog::logger& logger,
+		ContactSampling) {
 	// set up some stuff
+	auto& pop = *cluster.m_population;
 	const auto c_type = cluster.m_cluster_type;
 	const auto& c_members = cluster.m_members;
-	const auto transmission_rate = disease_profile.getTransmissionRate();
+	const auto& c_classes = pop.getPresenceClasses();
+	const auto c_present = cluster.presentClasses();
+	const auto transmission_probability = rateToProbability(disease_profile.getTransmissionRate());
 
 	// check all contacts
 	for (size_t i_person1 = 0; i_person1 < c_members.size(); i_person1++) {
 		// check if member is present today
-		if (c_members[i_person1].second) {
-			auto p1 = c_members[i_person1].first;
-			const double contact_rate = cluster.getContactRate(p1);
+		if (c_present[c_classes[c_members[i_person1]]]) {
+			const auto p1 = c_members[i_person1];
+			const double contact_probability = cluster.getContactProbability(pop.getEffectiveAge(p1));
 
 			// loop over possible contacts
 			// FIXME should this loop start from 0? Because of asymm. contact rates
 			for (size_t i_person2 = i_person1 + 1; i_person2 < c_members.size(); i_person2++) {
 				// check if member is present today
-				if (c_members[i_person2].second) {
-					auto p2 = c_members[i_person2].first;
+				if (c_present[c_classes[c_members[i_person2]]]) {
+					const auto p2 = c_members[i_person2];
 
 					// check for contact
-					if (contact_handler.hasContact(contact_rate)) {
+					if (contact_handler.hasSuccess(contact_probability)) {
 						// exchange information about health state & beliefs
-						local_information_policy::update(p1, p2);
+						local_information_policy::update(&pop.getPerson(p1), &pop.getPerson(p2));
 
-						bool transmission = contact_handler.hasTransmission(transmission_rate);
+						bool transmission = contact_handler.hasSuccess(transmission_probability);
 						if (transmission) {
-							if (p1->getHealth().isInfectious() && p2->getHealth().isSusceptible()) {
-								LOG_POLICY<log_level>::execute(logger, p1, p2, c_type, calendar);
-								p2->getHealth().startInfection();
-								R0_POLICY<track_index_case>::execute(p2);
-							} else if (p2->getHealth().isInfectious() && p1->getHealth().isSusceptible()) {
-								LOG_POLICY<log_level>::execute(logger, p2, p1, c_type, calendar);
-								p1->getHealth().startInfection();
-								R0_POLICY<track_index_case>::execute(p1);
+							const auto status1 = pop.getHealthStatus(p1);
+							const auto status2 = pop.getHealthStatus(p2);
+							if (Health::isInfectious(status1) && status2 == HealthStatus::Susceptible) {
+								LOG_POLICY<log_level>::execute(logger, pop, p1, p2, c_type, calendar);
+								pop.startInfection(p2);
+								R0_POLICY<track_index_case>::execute(pop, p2);
+							} else if (Health::isInfectious(status2) && status1 == HealthStatus::Susceptible) {
+								LOG_POLICY<log_level>::execute(logger, pop, p2, p1, c_type, calendar);
+								pop.startInfection(p1);
+								R0_POLICY<track_index_case>::execute(pop, p1);
 							}
 						}
 					}
@@ -161,7 +169,8 @@ void Infector<log_level, track_index_case, local_information_policy>::execute(
 template<LogMode log_level, bool track_index_case>
 void Infector<log_level, track_index_case, NoLocalInformation>::execute(
 		Cluster& cluster, DiseaseProfile disease_profile,
-		util::Random& contact_handler, shared_ptr<const Calendar> calendar, spdlog::logger& logger) {
+		util::Random& contact_handler, shared_ptr<const Calendar> calendar, spdlog::logger& logger,
+		ContactSampling sampling, vector<Transmission>* transmissions) {
 
 	// check if the cluster has infected members and sort
 	bool infectious_cases;
@@ -169,31 +178,55 @@ void Infector<log_level, track_index_case, NoLocalInformation>::execute(
 	tie(infectious_cases, num_cases) = cluster.sortMembers();
 
 	if (infectious_cases) {
-		cluster.updateMemberPresence();
-
 		// set up some stuff
+		auto& pop = *cluster.m_population;
 		const auto c_type = cluster.m_cluster_type;
 		const auto c_immune = cluster.m_index_immune;
 		const auto& c_members = cluster.m_members;
-		const auto transmission_rate = disease_profile.getTransmissionRate();
+		const auto& c_classes = pop.getPresenceClasses();
+		const auto c_present = cluster.presentClasses();
 
 		// match infectious in first part with susceptible in second part, skip last part (immune)
 		for (size_t i_infected = 0; i_infected < num_cases; i_infected++) {
 			// check if member is present today
-			if (c_members[i_infected].second) {
-				const auto p1 = c_members[i_infected].first;
+			if (c_present[c_classes[c_members[i_infected]]]) {
+				const auto p1 = c_members[i_infected];
 				// FIXME Is it necessary to check for infectiousness here? Infectious members are already sorted...
-				if (p1->getHealth().isInfectious()) {
-					const double contact_rate = cluster.getContactRate(p1);
+				if (Health::isInfectious(pop.getHealthStatus(p1))) {
+					// contact and transmission in one draw, the same for every contact of p1
+					const double probability = cluster.getTransmissionProbability(pop.getEffectiveAge(p1));
+					auto infect = [&](PersonIndex p2) {
+						if (transmissions) {
+							transmissions->push_back({p1, p2, c_type});
+							return;
+						}
+						// already infected in this cluster by another member (as in transmit)
+						if (pop.getHealthStatus(p2) != HealthStatus::Susceptible) {
+							return;
+						}
+						LOG_POLICY<log_level>::execute(logger, pop, p1, p2, c_type, calendar);
+						pop.startInfection(p2);
+						R0_POLICY<track_index_case>::execute(pop, p2);
+					};
 					// FIXME if loop 2 in all contacts algorithm should start from 0, we should also implement this symmetry here!
-					for (size_t i_contact = num_cases; i_contact < c_immune; i_contact++) {
-						// check if member is present today
-						if (c_members[i_contact].second) {
-							auto p2 = c_members[i_contact].first;
-							if (contact_handler.hasContactAndTransmission(contact_rate, transmission_rate)) {
-								LOG_POLICY<log_level>::execute(logger, p1, p2, c_type, calendar);
-								p2->getHealth().startInfection();
-								R0_POLICY<track_index_case>::execute(p2);
+					if (sampling == ContactSampling::Geometric) {
+						// Every contact has the same probability of transmission, so skip straight
+						// to the next successful one instead of drawing for every contact.
+						size_t i_contact = num_cases + contact_handler.nextGeometricSkip(probability, c_immune - num_cases);
+						while (i_contact < c_immune) {
+							// check if member is present today
+							if (c_present[c_classes[c_members[i_contact]]]) {
+								infect(c_members[i_contact]);
+							}
+							i_contact += 1 + contact_handler.nextGeometricSkip(probability, c_immune - i_contact);
+						}
+					} else {
+						for (size_t i_contact = num_cases; i_contact < c_immune; i_contact++) {
+							// check if member is present today
+							if (c_present[c_classes[c_members[i_contact]]]) {
+								if (contact_handler.hasSuccess(probability)) {
+									infect(c_members[i_contact]);
+								}
 							}
 						}
 					}
@@ -204,46 +237,72 @@ void Infector<log_level, track_index_case, NoLocalInformation>::execute(
 }
 
 
+template<LogMode log_level, bool track_index_case>
+void Infector<log_level, track_index_case, NoLocalInformation>::transmit(
+		Population& pop, const Transmission& transmission, shared_ptr<const Calendar> calendar,
+		spdlog::logger& logger) {
+	// the same person can be infected in several clusters on one day, only the first counts
+	if (pop.getHealthStatus(transmission.infected) == HealthStatus::Susceptible) {
+		LOG_POLICY<log_level>::execute(logger, pop, transmission.infector, transmission.infected,
+									   transmission.cluster_type, calendar);
+		pop.startInfection(transmission.infected);
+		R0_POLICY<track_index_case>::execute(pop, transmission.infected);
+	}
+}
+
+
 //-------------------------------------------------------------------------------------------
 // Definition of partial specialization for LogMode::Contacts and NoLocalInformation policy.
 //-------------------------------------------------------------------------------------------
 template<bool track_index_case>
 void Infector<LogMode::Contacts, track_index_case, NoLocalInformation>::execute(
 		Cluster& cluster, DiseaseProfile disease_profile,
-		util::Random& contact_handler, shared_ptr<const Calendar> calendar, spdlog::logger& logger) {
-
-	cluster.updateMemberPresence();
+		util::Random& contact_handler, shared_ptr<const Calendar> calendar, spdlog::logger& logger,
+		ContactSampling, vector<Transmission>* transmissions) {
 
 	// set up some stuff
+	auto& pop = *cluster.m_population;
 	const auto c_type = cluster.m_cluster_type;
 	const auto& c_members = cluster.m_members;
-	const auto transmission_rate = disease_profile.getTransmissionRate();
+	const auto& c_classes = pop.getPresenceClasses();
+	const auto c_present = cluster.presentClasses();
+	const auto transmission_probability = rateToProbability(disease_profile.getTransmissionRate());
 
 	// check all contacts
 	for (size_t i_person1 = 0; i_person1 < c_members.size(); i_person1++) {
 		// check if member participates in the social contact survey && member is present today
-		if (c_members[i_person1].second && c_members[i_person1].first->isParticipatingInSurvey()) {
-			auto p1 = c_members[i_person1].first;
-			const double contact_rate = cluster.getContactRate(p1);
+		if (c_present[c_classes[c_members[i_person1]]] && pop.getPerson(c_members[i_person1]).isParticipatingInSurvey()) {
+			const auto p1 = c_members[i_person1];
+			const double contact_probability = cluster.getContactProbability(pop.getEffectiveAge(p1));
 			// loop over possible contacts
 			for (size_t i_person2 = i_person1 + 1; i_person2 < c_members.size(); i_person2++) {
 				// check if member is present today
-				if (c_members[i_person2].second) {
-					auto p2 = c_members[i_person2].first;
+				if (c_present[c_classes[c_members[i_person2]]]) {
+					const auto p2 = c_members[i_person2];
 					// check for contact
-					if (contact_handler.hasContact(contact_rate)) {
-						bool transmission = contact_handler.hasTransmission(transmission_rate);
+					if (contact_handler.hasSuccess(contact_probability)) {
+						bool transmission = contact_handler.hasSuccess(transmission_probability);
 						if (transmission) {
-							if (p1->getHealth().isInfectious() && p2->getHealth().isSusceptible()) {
-								p2->getHealth().startInfection();
-								R0_POLICY<track_index_case>::execute(p2);
-							} else if (p2->getHealth().isInfectious() && p1->getHealth().isSusceptible()) {
-								p1->getHealth().startInfection();
-								R0_POLICY<track_index_case>::execute(p1);
+							const auto status1 = pop.getHealthStatus(p1);
+							const auto status2 = pop.getHealthStatus(p2);
+							if (Health::isInfectious(status1) && status2 == HealthStatus::Susceptible) {
+								if (transmissions) {
+									transmissions->push_back({p1, p2, c_type});
+								} else {
+									pop.startInfection(p2);
+									R0_POLICY<track_index_case>::execute(pop, p2);
+								}
+							} else if (Health::isInfectious(status2) && status1 == HealthStatus::Susceptible) {
+								if (transmissions) {
+									transmissions->push_back({p2, p1, c_type});
+								} else {
+									pop.startInfection(p1);
+									R0_POLICY<track_index_case>::execute(pop, p1);
+								}
 							}
 						}
 
-						LOG_POLICY<LogMode::Contacts>::execute(logger, p1, p2, c_type, calendar);
+						LOG_POLICY<LogMode::Contacts>::execute(logger, pop, p1, p2, c_type, calendar);
 					}
 				}
 			}
@@ -252,6 +311,16 @@ void Infector<LogMode::Contacts, track_index_case, NoLocalInformation>::execute(
 }
 
 
+template<bool track_index_case>
+void Infector<LogMode::Contacts, track_index_case, NoLocalInformation>::transmit(
+		Population& pop, const Transmission& transmission, shared_ptr<const Calendar>, spdlog::logger&) {
+	if (pop.getHealthStatus(transmission.infected) == HealthStatus::Susceptible) {
+		pop.startInfection(transmission.infected);
+		R0_POLICY<track_index_case>::execute(pop, transmission.infected);
+	}
+}
+
+
 //--------------------------------------------------------------------------
 // All explicit instantiations.
 //--------------------------------------------------------------------------
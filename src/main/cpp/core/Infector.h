@@ -22,10 +22,14 @@
 #include "behaviour/information_policies/NoLocalInformation.h"
 #include "behaviour/information_policies/LocalDiscussion.h"
 
+#include "core/ClusterType.h"
+#include "core/ContactSampling.h"
 #include "core/DiseaseProfile.h"
 #include "core/LogMode.h"
+#include "pop/Population.h"
 
 #include <memory>
+#include <vector>
 #include <spdlog/logger.h>
 
 namespace stride {
@@ -35,37 +39,60 @@ class Cluster;
 class Calendar;
 namespace util { class Random; }
 
+/// A transmission found in a cluster, for when the infection itself has to wait (see Infector::transmit).
+struct Transmission {
+	PersonIndex infector;
+	PersonIndex infected;
+	ClusterType cluster_type;
+};
+
 /**
  * Actual contacts and transmission in cluster (primary template).
+ * Every contact is needed to exchange information, so the sampling is always pairwise.
  */
 template<LogMode log_level, bool track_index_case, typename local_information_policy>
 class Infector {
 public:
 	static void execute(Cluster& cluster, DiseaseProfile disease_profile,
 						util::Random& contact_handler, std::shared_ptr<const Calendar> calendar,
-						spdlog::logger& logger);
+						spdlog::logger& logger, ContactSampling sampling = ContactSampling::Pairwise);
 };
 
 /**
  * Actual contacts and transmissions in cluster (specialization for NoLocalInformation policy)
+ * Only contacts with transmission matter, so these can be sampled with the given ContactSampling.
  */
 template<LogMode log_level, bool track_index_case>
 class Infector<log_level, track_index_case, NoLocalInformation> {
 public:
+	/// Without transmissions, infections start right away. Otherwise they are collected
+	/// there, and the health of the population is left alone (so clusters can share members).
 	static void execute(Cluster& cluster, DiseaseProfile disease_profile,
 						util::Random& contact_handler, std::shared_ptr<const Calendar> calendar,
-						spdlog::logger& logger);
+						spdlog::logger& logger, ContactSampling sampling = ContactSampling::Pairwise,
+						std::vector<Transmission>* transmissions = nullptr);
+
+	/// Infect the person of a collected transmission, if still susceptible.
+	static void transmit(Population& pop, const Transmission& transmission,
+						 std::shared_ptr<const Calendar> calendar, spdlog::logger& logger);
 };
 
 /**
  * Actual contacts and transmission in cluster (specialization for logging all contacts, and with NoLocalInformation policy).
+ * Every contact is logged, so the sampling is always pairwise.
  */
 template<bool track_index_case>
 class Infector<LogMode::Contacts, track_index_case, NoLocalInformation> {
 public:
+	/// Collects the transmissions when given, as above.
 	static void execute(Cluster& cluster, DiseaseProfile disease_profile,
 						util::Random& contact_handler, std::shared_ptr<const Calendar> calendar,
-						spdlog::logger& logger);
+						spdlog::logger& logger, ContactSampling sampling = ContactSampling::Pairwise,
+						std::vector<Transmission>* transmissions = nullptr);
+
+	/// Infect the person of a collected transmission, if still susceptible.
+	static void transmit(Population& pop, const Transmission& transmission,
+						 std::shared_ptr<const Calendar> calendar, spdlog::logger& logger);
 };
 
 
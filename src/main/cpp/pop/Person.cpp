@@ -14,7 +14,6 @@
  */
 
 
-#include "Age.h"
 #include "Person.h"
 
 #include "core/ClusterType.h"
@@ -42,25 +41,7 @@ unsigned int Person<BehaviourPolicy, BeliefPolicy>::getClusterId(ClusterType clu
 }
 
 template<class BehaviourPolicy, class BeliefPolicy>
-bool Person<BehaviourPolicy, BeliefPolicy>::isInCluster(ClusterType c) const {
-	switch (c) {
-		case ClusterType::Household:
-			return m_at_household && !m_is_on_vacation;
-		case ClusterType::School:
-			return m_at_school && !m_is_on_vacation;
-		case ClusterType::Work:
-			return m_at_work && !m_is_on_vacation;
-		case ClusterType::PrimaryCommunity:
-			return m_at_primary_community && !m_is_on_vacation;
-		case ClusterType::SecondaryCommunity:
-			return m_at_secondary_community && !m_is_on_vacation;
-		default:
-			throw runtime_error(string(__func__) + "> Should not reach default.");
-	}
-}
-
-template<class BehaviourPolicy, class BeliefPolicy>
-void Person<BehaviourPolicy, BeliefPolicy>::update(bool is_work_off, bool is_school_off, double fraction_infected) {
+void Person<BehaviourPolicy, BeliefPolicy>::update(double fraction_infected) {
 	m_health.update();
 
 	// Vaccination behavior
@@ -72,19 +53,6 @@ void Person<BehaviourPolicy, BeliefPolicy>::update(bool is_work_off, bool is_sch
 		}
 	}
 
-	// Update presence in clusters.
-	if (is_work_off || (m_age <= minAdultAge() && is_school_off)) {
-		m_at_school = false;
-		m_at_work = false;
-		m_at_secondary_community = false;
-		m_at_primary_community = true;
-	} else {
-		m_at_school = true;
-		m_at_work = true;
-		m_at_secondary_community = true;
-		m_at_primary_community = false;
-	}
-
 	BeliefPolicy::update(m_belief_data, m_health);
 }
 
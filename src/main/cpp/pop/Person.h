@@ -56,8 +56,6 @@ public:
 			  m_household_id(household_id), m_school_id(school_id),
 			  m_work_id(work_id), m_primary_community_id(primary_community_id),
 			  m_secondary_community_id(secondary_community_id),
-			  m_at_household(true), m_at_school(true), m_at_work(true), m_at_primary_community(true),
-			  m_at_secondary_community(true),
 			  m_health(start_infectiousness, start_symptomatic, time_infectious, time_symptomatic),
 			  m_is_participant(false), m_is_on_vacation(is_on_vacation) {
 		BeliefPolicy::initialize(m_belief_data, risk_averseness);
@@ -87,17 +85,14 @@ public:
 	/// Get the id.
 	unsigned int getId() const { return m_id; }
 
-	/// Check if a person is present today in a given cluster
-	bool isInCluster(ClusterType c) const;
-
 	/// Does this person participates in the social contact study?
 	bool isParticipatingInSurvey() const { return m_is_participant; }
 
 	/// Participate in social contact study and log person details
 	void participateInSurvey() { m_is_participant = true; }
 
-	/// Update the health status and presence in clusters.
-	void update(bool is_work_off, bool is_school_off, double fraction_infected);
+	/// Update the health status and beliefs (presence in clusters is kept by the Population).
+	void update(double fraction_infected);
 
 	/// Update belief & behaviour upon meeting another Person
 	void update(const Person* p);
@@ -120,12 +115,6 @@ private:
 	unsigned int m_primary_community_id;   ///< The primary community id
 	unsigned int m_secondary_community_id; ///< The secondary community id
 
-	bool m_at_household;           ///< Is person present at household today?
-	bool m_at_school;              ///< Is person present at school today?
-	bool m_at_work;                ///< Is person present at work today?
-	bool m_at_primary_community;   ///< Is person present at primary_community today?
-	bool m_at_secondary_community; ///< Is person present at secundary_community today?
-
 	Health m_health;                           ///< Health info for this person.
 	typename BeliefPolicy::Data m_belief_data; ///< Info w.r.t. this Person's health beliefs
 
@@ -1,20 +1,281 @@
-
 #include "Population.h"
 
+#include <algorithm>
+
 using namespace stride;
 using namespace util;
 using namespace std;
 
+namespace {
+
+/// Number of consecutive indices a thread updates in one go.
+const size_t g_update_block_size = 4096U;
+
+size_t numBlocks(size_t count) {
+	return (count + g_update_block_size - 1) / g_update_block_size;
+}
+
+}
+
 // Population
 // ----------
 
+void Population::update(bool is_work_off, bool is_school_off, double fraction_infected, Parallel& parallel) {
+	growColumns(m_original.size() + m_visitor_slots.size());
+	m_day++;
+	m_presence_masks = presenceMasks(is_work_off, is_school_off);
+
+	if (isEventDriven()) {
+		updateHealth(parallel);
+		return;
+	}
+
+	// The persons (originals first, then the visitor slots) are updated independently, the
+	// set of infectious persons is not thread safe and is brought up to date afterwards.
+	const size_t count = m_health_status.size();
+	vector<vector<PersonIndex>> changed(numBlocks(count));
+	parallel.for_(0U, changed.size(), [&](size_t block) {
+		const size_t last = min(count, (block + 1) * g_update_block_size);
+		for (PersonIndex i = block * g_update_block_size; i < last; ++i) {
+			PersonType* p = i < m_original.size() ? &m_original[i] : m_visitor_slots[i - m_original.size()];
+			// People on vacation are updated by the simulator they are visiting.
+			if (p == nullptr || p->isOnVacation()) {
+				continue;
+			}
+			p->update(fraction_infected);
+			if (p->getHealth().getHealthStatus() != m_health_status[i]) {
+				changed[block].push_back(i);
+			}
+		}
+	});
+	for (const auto& block_changed: changed) {
+		for (const auto i: block_changed) {
+			setHealthStatus(i, getPerson(i).getHealth().getHealthStatus());
+		}
+	}
+}
+
+void Population::updateHealth(Parallel& parallel) {
+	auto it = m_health_events.find(m_day);
+	if (it == m_health_events.end()) {
+		return;
+	}
+	// Only the last event scheduled for a person counts (see scheduleHealth), so a person is
+	// never updated twice, let alone by two threads at once.
+	vector<PersonIndex> persons;
+	persons.reserve(it->second.size());
+	for (const auto index: it->second) {
+		if (m_health_event_day[index] == m_day) {
+			m_health_event_day[index] = 0U;
+			persons.push_back(index);
+		}
+	}
+	m_health_events.erase(it);
+
+	// As in update: the diseases advance in parallel, the bookkeeping is done afterwards (in order).
+	vector<vector<PersonIndex>> changed(numBlocks(persons.size()));
+	parallel.for_(0U, changed.size(), [&](size_t block) {
+		const size_t last = min(persons.size(), (block + 1) * g_update_block_size);
+		for (size_t j = block * g_update_block_size; j < last; ++j) {
+			const PersonIndex index = persons[j];
+			PersonType* p = index < m_original.size() ? &m_original[index] : m_visitor_slots[index - m_original.size()];
+			if (p == nullptr || p->isOnVacation()) {
+				continue;
+			}
+			// Skip events that were overtaken (a new infection, a record that was replaced, ...).
+			auto& health = p->getHealth();
+			const unsigned int days = health.getDaysToNextTransition();
+			if (days == 0U || m_health_day[index] + days != m_day) {
+				continue;
+			}
+			health.advanceDiseaseCounter(days - 1U);
+			health.update();
+			m_health_day[index] = m_day;
+			changed[block].push_back(index);
+		}
+	});
+	for (const auto& block_changed: changed) {
+		for (const auto index: block_changed) {
+			setHealthStatus(index, getPerson(index).getHealth().getHealthStatus());
+			scheduleHealth(index);
+		}
+	}
+}
+
+void Population::scheduleHealth(PersonIndex index) {
+	const unsigned int days = getPerson(index).getHealth().getDaysToNextTransition();
+	if (days != 0U) {
+		const unsigned int day = m_health_day[index] + days;
+		lock_guard<mutex> lock(m_health_events_mutex);
+		if (m_health_event_day[index] != day) {
+			m_health_event_day[index] = day;
+			m_health_events[day].push_back(index);
+		}
+	}
+}
+
+void Population::startInfection(PersonIndex index) {
+	getPerson(index).getHealth().startInfection();
+	countHealthStatus(index, m_health_status[index], HealthStatus::Exposed);
+	m_health_status[index] = HealthStatus::Exposed;
+	if (isEventDriven()) {
+		m_health_day[index] = m_day;
+		scheduleHealth(index);
+	}
+}
+
+void Population::stopInfection(PersonIndex index) {
+	getPerson(index).getHealth().stopInfection();
+	countHealthStatus(index, m_health_status[index], HealthStatus::Recovered);
+	m_health_status[index] = HealthStatus::Recovered;
+}
+
+PopulationStats Population::getStats() const {
+	return PopulationStats(getStatusCounts(), getAdoptedCount<Simulator::BeliefPolicy>());
+}
+
 unsigned int Population::getInfectedCount() const {
-	unsigned int total = 0;
-	for (const auto& p : *this) {
-		const auto& h = p.getHealth();
-		total += h.isInfected() || h.isRecovered();
+	// The number of adopters is not needed here.
+	return PopulationStats(getStatusCounts(), 0U).getInfectedCount();
+}
+
+double Population::getFractionInfected() const {
+	return PopulationStats(getStatusCounts(), 0U).getFractionInfected();
+}
+
+PopulationStats::Counts Population::getStatusCounts() const {
+	PopulationStats::Counts counts;
+	for (size_t i = 0; i < counts.size(); i++) {
+		counts[i] = m_status_counts[i];
+	}
+	return counts;
+}
+
+void Population::syncHealth(PersonIndex index) {
+	auto& health = getPerson(index).getHealth();
+	health.advanceDiseaseCounter(getDiseaseCounter(index) - health.getDiseaseCounter());
+	m_health_day[index] = m_day;
+}
+
+unsigned int Population::getDiseaseCounter(PersonIndex index) const {
+	const PersonType& p = getPerson(index);
+	const auto& health = p.getHealth();
+	// The counter only runs while infected, and not while away (see update).
+	if (not isEventDriven() or not health.isInfected() or p.isOnVacation()) {
+		return health.getDiseaseCounter();
+	}
+	return health.getDiseaseCounter() + (m_day - m_health_day[index]);
+}
+
+void Population::syncColumns() {
+	growColumns(m_original.size() + m_visitor_slots.size());
+	for (auto& count: m_status_counts) {
+		count = 0U;
+	}
+	fill(m_presence_class.begin(), m_presence_class.end(), 0U);
+	for (PersonIndex i = 0; i < m_health_status.size(); ++i) {
+		syncColumns(i);
+	}
+}
+
+void Population::syncColumns(PersonIndex index) {
+	const PersonType* p = index < m_original.size() ? &m_original[index] : m_visitor_slots[index - m_original.size()];
+	m_health_day[index] = m_day;
+	// Leave the counts while absent (the status of an absent person is not counted).
+	countHealthStatus(index, m_health_status[index], HealthStatus::Null);
+	m_presence_class[index] = 0U;
+	if (p == nullptr) {
+		setHealthStatus(index, HealthStatus::Null);
+		m_age[index] = 0U;
+	} else {
+		setHealthStatus(index, p->getHealth().getHealthStatus());
+		m_presence_class[index] = p->isOnVacation() ? 0U : (p->getAge() <= minAdultAge() ? 1U : 2U);
+		countHealthStatus(index, HealthStatus::Null, m_health_status[index]);
+		m_age[index] = effectiveAge(p->getAge());
+		if (isEventDriven() and not p->isOnVacation()) {
+			scheduleHealth(index);
+		}
+	}
+}
+
+void Population::setHealthStatus(PersonIndex index, HealthStatus status) {
+	const bool was_infectious = Health::isInfectious(m_health_status[index]);
+	const bool is_infectious = Health::isInfectious(status);
+	countHealthStatus(index, m_health_status[index], status);
+	m_health_status[index] = status;
+	if (is_infectious && !was_infectious) {
+		m_infectious.insert(index);
+	} else if (was_infectious && !is_infectious) {
+		m_infectious.erase(index);
+	}
+}
+
+void Population::growColumns(std::size_t count) {
+	if (m_health_status.size() < count) {
+		m_health_status.resize(count, HealthStatus::Null);
+		m_presence_class.resize(count, 0U);
+		m_age.resize(count, 0U);
+		m_health_day.resize(count, m_day);
+		m_health_event_day.resize(count, 0U);
+	}
+}
+
+void Population::countHealthStatus(PersonIndex index, HealthStatus from, HealthStatus to) {
+	// Null is not counted, which also serves to enter or leave the counts.
+	if (m_presence_class[index] == 0U || from == to) {
+		return;
+	}
+	if (from != HealthStatus::Null) {
+		m_status_counts[static_cast<size_t>(from)]--;
+	}
+	if (to != HealthStatus::Null) {
+		m_status_counts[static_cast<size_t>(to)]++;
+	}
+}
+
+std::array<unsigned char, 3> Population::presenceMasks(bool is_work_off, bool is_school_off) {
+	const unsigned char household = 1U << toSizeType(ClusterType::Household);
+	const unsigned char weekend = household | (1U << toSizeType(ClusterType::PrimaryCommunity));
+	const unsigned char weekday = household | (1U << toSizeType(ClusterType::School))
+								  | (1U << toSizeType(ClusterType::Work))
+								  | (1U << toSizeType(ClusterType::SecondaryCommunity));
+	// Absent, child (up to minAdultAge) and adult.
+	return {{0U, (is_work_off || is_school_off) ? weekend : weekday, is_work_off ? weekend : weekday}};
+}
+
+PersonIndex Population::addVisitor(unsigned int days, const PersonType& person) {
+	m_visitors.add(days, person);
+	PersonType* visitor = m_visitors.getModifiableDay(days)->back().get();
+
+	PersonIndex index;
+	if (m_free_slots.empty()) {
+		index = m_original.size() + m_visitor_slots.size();
+		m_visitor_slots.push_back(visitor);
+	} else {
+		index = m_free_slots.back();
+		m_free_slots.pop_back();
+		m_visitor_slots[index - m_original.size()] = visitor;
+	}
+	m_visitor_indices[visitor] = index;
+
+	growColumns(index + 1);
+	syncColumns(index);
+	return index;
+}
+
+void Population::removeVisitor(PersonIndex index) {
+	PersonType*& visitor = m_visitor_slots.at(index - m_original.size());
+	m_visitor_indices.erase(visitor);
+	visitor = nullptr;
+	m_free_slots.push_back(index);
+	syncColumns(index);
+}
+
+PersonIndex Population::getIndex(const PersonType* person) const {
+	if (not m_original.empty() and person >= &m_original.front() and person <= &m_original.back()) {
+		return person - m_original.data();
 	}
-	return total;
+	return m_visitor_indices.at(person);
 }
 
 #define PopulationBeginEnd(mod, type) \
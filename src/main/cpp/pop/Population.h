@@ -19,12 +19,23 @@
  * Header file for the core Population class
  */
 
+#include "Age.h"
 #include "Person.h"
+#include "PopulationStats.h"
+#include "core/ClusterType.h"
 #include "core/Health.h"
 #include "sim/Simulator.h"
 #include "util/SimplePlanner.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
 #include <numeric>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace stride {
@@ -126,8 +137,27 @@ class PopulationIterator;
 
 class ConstPopulationIterator;
 
+/// Index of a person in the columns of a Population: the persons in m_original
+/// come first (index == position), registered visitors come after them.
+using PersonIndex = std::uint32_t;
+
 /**
  * Container for persons in population.
+ *
+ * Besides the Person records, the population keeps the state that the daily
+ * cluster loops need in separate contiguous columns (health status, presence
+ * class and effective age), indexed by PersonIndex. Clusters refer to their
+ * members by that index, so the contact loops never touch the Person records
+ * unless something actually happens (a transmission or a logged contact).
+ * The columns are refreshed by update() and kept in sync by the methods below
+ * that change health; syncColumns() rebuilds them after the records have been
+ * changed directly (building, loading a checkpoint, travel, ...).
+ *
+ * When the behaviour and belief policies do nothing (see isEventDriven), the
+ * progression of the disease is event driven: the days on which the health
+ * status of a person changes are kept in a calendar queue and update() only
+ * visits those persons. Disease counters are then only brought up to date on
+ * those days; use getDiseaseCounter() or syncHealth() to read them.
  */
 class Population {
 public:
@@ -137,13 +167,87 @@ public:
 	using PlannerType = SimplePlanner<PersonType>;
 	using VectorType = vector<PersonType>;
 
-	/// Get the cumulative number of cases.
-	unsigned int getInfectedCount() const;
+	/// Advance a day: update health (and beliefs) of everyone present and set today's presence.
+	void update(bool is_work_off, bool is_school_off, double fraction_infected, Parallel& parallel);
 
-	double getFractionInfected() const {
-		return getInfectedCount() / (this->m_original.size() + this->m_visitors.size());
+	/// Is the progression of the disease event driven (the daily update of a Person only changes its Health)?
+	static constexpr bool isEventDriven() {
+		return std::is_same<Simulator::BehaviourPolicy, NoBehaviour<NoBelief>>::value
+			   && std::is_same<Simulator::BeliefPolicy, NoBelief>::value;
 	}
 
+	/// Rebuild the columns from the Person records.
+	void syncColumns();
+
+	/// Copy the state of the person with the given index to the columns (after changing the record directly).
+	void syncColumns(PersonIndex index);
+
+	/// Bring the disease counter in the record of the person with the given index up to date.
+	void syncHealth(PersonIndex index);
+
+	/// Disease counter of the person with the given index, as if it were updated daily.
+	unsigned int getDiseaseCounter(PersonIndex index) const;
+
+	/// Add a visitor to the planner (leaving after the given amount of days) and give it an index.
+	PersonIndex addVisitor(unsigned int days, const PersonType& person);
+
+	/// Release the index of a visitor, the Person itself is removed from the planner by nextDay().
+	void removeVisitor(PersonIndex index);
+
+	/// Get the index of a person (either in m_original or a registered visitor).
+	PersonIndex getIndex(const PersonType* person) const;
+
+	/// Number of indices in use (m_original plus visitor slots, including free ones).
+	std::size_t getIndexCount() const { return m_health_status.size(); }
+
+	/// Get the person with the given index.
+	PersonType& getPerson(PersonIndex index) {
+		return index < m_original.size() ? m_original[index] : *m_visitor_slots[index - m_original.size()];
+	}
+
+	/// Get the person with the given index.
+	const PersonType& getPerson(PersonIndex index) const {
+		return index < m_original.size() ? m_original[index] : *m_visitor_slots[index - m_original.size()];
+	}
+
+	/// Health status of the person with the given index.
+	HealthStatus getHealthStatus(PersonIndex index) const { return m_health_status[index]; }
+
+	/// Is the person with the given index present in a cluster of the given type today?
+	bool isInCluster(PersonIndex index, ClusterType type) const {
+		return (m_presence_masks[m_presence_class[index]] >> toSizeType(type)) & 1U;
+	}
+
+	/// Presence class of everyone (absent, child or adult), by index.
+	const vector<unsigned char>& getPresenceClasses() const { return m_presence_class; }
+
+	/// Presence bits (bit per ClusterType) of each presence class today.
+	const std::array<unsigned char, 3>& getPresenceMasks() const { return m_presence_masks; }
+
+	/// Effective age (see effectiveAge) of the person with the given index.
+	unsigned int getEffectiveAge(PersonIndex index) const { return m_age[index]; }
+
+	/// Indices of everyone who is infectious (see Health::isInfectious), kept up to date with the health status.
+	const std::unordered_set<PersonIndex>& getInfectious() const { return m_infectious; }
+
+	/// Start the infection of the person with the given index.
+	/// Exposed is not infectious (nor is the susceptible state before it), so the set
+	/// of infectious persons is unaffected and this is safe to call from the cluster loops.
+	void startInfection(PersonIndex index);
+
+	/// Stop the infection of the person with the given index (only used right after startInfection).
+	void stopInfection(PersonIndex index);
+
+	/// Number of persons by health status (kept up to date with the columns), and of adopters
+	/// (counted by a scan of everyone present).
+	PopulationStats getStats() const;
+
+	/// Get the cumulative number of cases (from the counts, without the scan of getStats).
+	unsigned int getInfectedCount() const;
+
+	/// Fraction of the persons present that is or has been infected (from the counts, as getInfectedCount).
+	double getFractionInfected() const;
+
 	size_t size() const {
 		return m_original.size() + m_visitors.size();
 	}
@@ -166,6 +270,47 @@ public:
 	// standard library style
 	using iterator = PopulationIterator;
 	using const_iterator = ConstPopulationIterator;
+
+private:
+	/// Presence bits (one bit per ClusterType) of every presence class on a day.
+	static std::array<unsigned char, 3> presenceMasks(bool is_work_off, bool is_school_off);
+
+	/// Advance the disease of the persons whose health changes today.
+	void updateHealth(Parallel& parallel);
+
+	/// Put the next change in health of the person with the given index in the calendar queue
+	/// (a person has one pending event, the one scheduled last).
+	void scheduleHealth(PersonIndex index);
+
+	/// Change the health status column and keep the set of infectious persons in sync.
+	void setHealthStatus(PersonIndex index, HealthStatus status);
+
+	/// Make sure the columns can hold the given index.
+	void growColumns(std::size_t count);
+
+	/// Move a person present in the region from one health status to another in the counts.
+	void countHealthStatus(PersonIndex index, HealthStatus from, HealthStatus to);
+
+	/// Copy of the number of persons present, by health status.
+	PopulationStats::Counts getStatusCounts() const;
+
+private:
+	vector<PersonType*> m_visitor_slots;   ///< Registered visitors, by index - m_original.size() (nullptr if free).
+	vector<PersonIndex> m_free_slots;      ///< Visitor slots that can be reused.
+	std::unordered_map<const PersonType*, PersonIndex> m_visitor_indices;  ///< Index of every registered visitor.
+
+	vector<HealthStatus> m_health_status;  ///< Health status, by index.
+	std::unordered_set<PersonIndex> m_infectious;  ///< Indices with an infectious health status.
+	std::array<std::atomic<unsigned int>, static_cast<std::size_t>(HealthStatus::Null)> m_status_counts {};  ///< Number of persons present, by health status.
+	vector<unsigned char> m_presence_class;     ///< Presence class (0: absent, 1: child, 2: adult), by index.
+	std::array<unsigned char, 3> m_presence_masks {{0U, 0x1FU, 0x1FU}};  ///< Presence bits of each class today.
+	vector<unsigned char> m_age;           ///< Effective age, by index.
+
+	unsigned int m_day = 0U;               ///< Number of days the population has been updated.
+	vector<unsigned int> m_health_day;     ///< Day up to which the disease counter in the record is valid, by index.
+	vector<unsigned int> m_health_event_day;  ///< Day of the pending event in the calendar queue (0 if none), by index.
+	std::map<unsigned int, vector<PersonIndex>> m_health_events;  ///< Persons whose health may change, by day.
+	std::mutex m_health_events_mutex;      ///< Infections are scheduled from the (parallel) cluster loops.
 };
 
 
@@ -192,12 +337,14 @@ public:
 
 template<typename BeliefPolicy>
 unsigned int Population::getAdoptedCount() const {
-	unsigned int total {0U};
+	// Nobody ever adopts without a belief policy.
+	if (std::is_same<BeliefPolicy, NoBelief>::value) {
+		return 0U;
+	}
 
-	for (const auto& p: *this) {
-		auto belief_data = p.getBeliefData();
-		bool adopted = BeliefPolicy::hasAdopted(belief_data);
-		if (adopted) {
+	unsigned int total {0U};
+	for (PersonIndex i = 0; i < m_presence_class.size(); ++i) {
+		if (m_presence_class[i] != 0U and BeliefPolicy::hasAdopted(getPerson(i).getBeliefData())) {
 			total++;
 		}
 	}
@@ -19,11 +19,14 @@
  */
 
 #include "PopulationBuilder.h"
+#include "PopulationFile.h"
 
 #include "util/InstallDirs.h"
-#include "util/StringUtils.h"
+#include "util/MappedCsv.h"
+#include "util/Sampling.h"
 
 #include <boost/property_tree/xml_parser.hpp>
+#include <array>
 
 namespace stride {
 
@@ -36,11 +39,10 @@ shared_ptr<Population> PopulationBuilder::build(
 		const boost::property_tree::ptree& pt_config,
 		const boost::property_tree::ptree& pt_disease,
 		const boost::property_tree::ptree& pt_pop,
-		util::Random& rng) {
+		util::Random& rng, Parallel& parallel) {
 	//------------------------------------------------
 	// Setup.
 	//------------------------------------------------
-	// TODO first determine how many people are needed (by scanning the file twice)
 	const auto pop = make_shared<Population>();
 	Population::VectorType& population = pop->m_original;
 	const double seeding_rate = pt_config.get<double>("run.disease.seeding_rate");
@@ -65,52 +67,75 @@ shared_ptr<Population> PopulationBuilder::build(
 							+ "> Population (people) file " + file_path.string() + " not present.");
 	}
 
-	std::ifstream pop_file;
-	pop_file.open(file_path.string());
-	if (!pop_file.is_open()) {
-		throw runtime_error(string(__func__)
-							+ "> Error opening population file " + file_path.string());
-	}
-
 	const auto distrib_start_infectiousness = getDistribution(pt_disease, "disease.start_infectiousness");
 	const auto distrib_start_symptomatic = getDistribution(pt_disease, "disease.start_symptomatic");
 	const auto distrib_time_infectious = getDistribution(pt_disease, "disease.time_infectious");
 	const auto distrib_time_symptomatic = getDistribution(pt_disease, "disease.time_symptomatic");
 
-	string line;
-	getline(pop_file, line); // step over file header
-	unsigned int person_id = 0U;
-	while (getline(pop_file, line)) {
+	auto add_person = [&](unsigned int age, unsigned int household_id, unsigned int school_id, unsigned int work_id,
+						  unsigned int primary_community_id, unsigned int secondary_community_id,
+						  double risk_averseness) {
 		// Make use of stochastic disease characteristics.
 		const auto start_infectiousness = sample(rng, distrib_start_infectiousness);
 		const auto start_symptomatic = sample(rng, distrib_start_symptomatic);
 		const auto time_infectious = sample(rng, distrib_time_infectious);
 		const auto time_symptomatic = sample(rng, distrib_time_symptomatic);
-		const auto values = StringUtils::split(line, ",");
-		auto risk_averseness = 0.0;
-		if (values.size() > 6) {
-			risk_averseness = StringUtils::fromString<double>(values[6]);
-		}
-		population.emplace_back(Simulator::PersonType(person_id,
-													  StringUtils::fromString<unsigned int>(values[0]),
-													  StringUtils::fromString<unsigned int>(values[1]),
-													  StringUtils::fromString<unsigned int>(values[2]),
-													  StringUtils::fromString<unsigned int>(values[3]),
-													  StringUtils::fromString<unsigned int>(values[4]),
-													  StringUtils::fromString<unsigned int>(values[5]),
+		population.emplace_back(Simulator::PersonType(population.size(), age, household_id, school_id, work_id,
+													  primary_community_id, secondary_community_id,
 													  start_infectiousness, start_symptomatic, time_infectious,
 													  time_symptomatic, risk_averseness));
-		++person_id;
+	};
+
+	const auto format = pt_pop.get<string>("population.format", "csv");
+	if (format == "binary") {
+		// Columns of fixed width (see PopulationFile), nothing to parse.
+		const PopulationFile pop_file(file_path.string());
+		const auto age = pop_file.getColumn(PopulationFile::Column::Age);
+		const auto household = pop_file.getColumn(PopulationFile::Column::Household);
+		const auto school = pop_file.getColumn(PopulationFile::Column::School);
+		const auto work = pop_file.getColumn(PopulationFile::Column::Work);
+		const auto primary_community = pop_file.getColumn(PopulationFile::Column::PrimaryCommunity);
+		const auto secondary_community = pop_file.getColumn(PopulationFile::Column::SecondaryCommunity);
+		const auto risk_averseness = pop_file.getRiskAverseness();
+
+		population.reserve(pop_file.size());
+		for (size_t i = 0; i < pop_file.size(); i++) {
+			add_person(age[i], household[i], school[i], work[i], primary_community[i], secondary_community[i],
+					   risk_averseness ? risk_averseness[i] : 0.0);
+		}
+	} else if (format == "csv") {
+		// The lines are parsed in parallel, the persons are made in order (as they draw random numbers).
+		struct Line {
+			array<unsigned int, 6> ids;   // age, household, school, work, primary and secondary community
+			double risk_averseness;
+		};
+		const auto lines = MappedCsv(file_path.string()).parse<Line>(
+				[&](const MappedCsv::Field* values, size_t num_values) {
+					if (num_values < 6) {
+						throw runtime_error("PopulationBuilder::build> Bad line in population file " + file_name);
+					}
+					Line line;
+					for (size_t i = 0; i < 6; i++) {
+						line.ids[i] = values[i].toUnsigned();
+					}
+					line.risk_averseness = num_values > 6 ? values[6].toDouble() : 0.0;
+					return line;
+				}, parallel);
+
+		population.reserve(lines.size());
+		for (const auto& line: lines) {
+			add_person(line.ids[0], line.ids[1], line.ids[2], line.ids[3], line.ids[4], line.ids[5],
+					   line.risk_averseness);
+		}
+	} else {
+		throw runtime_error(string(__func__) + "> Invalid population format " + format + " (csv or binary).");
 	}
 
-	pop_file.close();
-
 	//------------------------------------------------
 	// Customize the population.
 	//------------------------------------------------
 
-	const unsigned int max_population_index = population.size() - 1;
-	if (max_population_index <= 1U) {
+	if (population.size() <= 2U) {
 		throw runtime_error(string(__func__) + "> Problem with population size.");
 	}
 	//------------------------------------------------
@@ -120,44 +145,85 @@ shared_ptr<Population> PopulationBuilder::build(
 	if (log_level == "Contacts") {
 		const unsigned int num_participants = pt_config.get<double>("run.outputs.participants_survey.<xmlattr>.num");
 
-		// use a while-loop to obtain 'num_participant' unique participants (default sampling is with replacement)
-		// A for loop will not do because we might draw the same person twice.
+		// A few participants out of many, so no table of candidates.
 		// TODO: getting a hold of a proper logger here is very difficult
-		unsigned int num_samples = 0;
-		while (num_samples < num_participants) {
-			Simulator::PersonType& p = population[rng(max_population_index)];
-			if (!p.isParticipatingInSurvey()) {
-				p.participateInSurvey();
-				//logger.info("[PART] {} {} {}", p.getId(), p.getAge(), p.getGender());
-				num_samples++;
-			}
+		for (const auto index: sampleIndices(population.size(), num_participants, rng)) {
+			population[index].participateInSurvey();
+			//logger.info("[PART] {} {} {}", p.getId(), p.getAge(), p.getGender());
 		}
 	}
 
 	//------------------------------------------------
 	// Set population immunity.
 	//------------------------------------------------
-	unsigned int num_immune = floor(static_cast<double>(population.size()) * immunity_rate);
-	while (num_immune > 0) {
-		Simulator::PersonType& p = population[rng(max_population_index)];
-		if (p.getHealth().isSusceptible()) {
-			p.getHealth().setImmune();
-			num_immune--;
+	// The persons are divided in age groups (strata) with their own immunity rate, the persons outside of the
+	// immunity profile have the general immunity rate. Shuffling the chosen persons to the front of their
+	// stratum leaves the ones that are still susceptible behind them.
+	struct Stratum {
+		double immunity_rate;
+		vector<PersonIndex> persons;
+	};
+	vector<Stratum> strata;
+	vector<pair<double, double>> age_groups;
+	const auto immunity_profile = pt_config.get_child_optional("run.disease.immunity_profile");
+	if (immunity_profile) {
+		for (const auto& group: *immunity_profile) {
+			const auto min_age = group.second.get<double>("<xmlattr>.min_age");
+			const auto max_age = group.second.get<double>("<xmlattr>.max_age");
+			const auto rate = group.second.get<double>("<xmlattr>.rate");
+			if (rate < 0 || rate > 1 || min_age > max_age) {
+				throw runtime_error(string(__func__) + "> Bad group in immunity profile.");
+			}
+			age_groups.emplace_back(min_age, max_age);
+			strata.push_back(Stratum{rate, {}});
+		}
+	}
+	strata.push_back(Stratum{immunity_rate, {}});
+	for (PersonIndex i = 0; i < population.size(); i++) {
+		const auto age = population[i].getAge();
+		size_t group = 0;
+		while (group < age_groups.size() && (age < age_groups[group].first || age > age_groups[group].second)) {
+			group++;
 		}
+		strata[group].persons.push_back(i);
+	}
+
+	// Only the choice is sequential (one random stream), the chosen persons are updated in parallel.
+	auto update_persons = [&](const vector<PersonIndex>& persons, size_t count, bool infect) {
+		const size_t block_size = 4096U;
+		parallel.for_(0U, (count + block_size - 1) / block_size, [&](size_t block) {
+			const size_t last = min(count, (block + 1) * block_size);
+			for (size_t i = block * block_size; i < last; i++) {
+				auto& health = population[persons[i]].getHealth();
+				if (infect) {
+					health.startInfection();
+				} else {
+					health.setImmune();
+				}
+			}
+		});
+	};
+
+	vector<PersonIndex> susceptibles;
+	susceptibles.reserve(population.size());
+	for (auto& stratum: strata) {
+		const size_t num_immune = floor(static_cast<double>(stratum.persons.size()) * stratum.immunity_rate);
+		shuffleFront(stratum.persons, num_immune, rng);
+		update_persons(stratum.persons, num_immune, false);
+		susceptibles.insert(susceptibles.end(), stratum.persons.begin() + num_immune, stratum.persons.end());
 	}
 
 	//------------------------------------------------
 	// Seed infected persons.
 	//------------------------------------------------
-	unsigned int num_infected = floor(static_cast<double> (population.size()) * seeding_rate);
-	while (num_infected > 0) {
-		Simulator::PersonType& p = population[rng(max_population_index)];
-		if (p.getHealth().isSusceptible()) {
-			p.getHealth().startInfection();
-			num_infected--;
-		}
+	const size_t num_infected = floor(static_cast<double>(population.size()) * seeding_rate);
+	if (num_infected > susceptibles.size()) {
+		throw runtime_error(string(__func__) + "> Not enough susceptible persons to seed the infection.");
 	}
+	shuffleFront(susceptibles, num_infected, rng);
+	update_persons(susceptibles, num_infected, true);
 
+	pop->syncColumns();
 	return pop;
 }
 
@@ -43,13 +43,14 @@ public:
 	 *
 	 * @param pt_config       Property_tree with generalconfiguration settings.
 	 * @param pt_disease      Property_tree with disease configuration settings.
+	 * @param parallel        Threads to parse the people file with.
 	 * @return                Pointer to the initialized population.
 	 */
 	static std::shared_ptr<Population> build(
 			const boost::property_tree::ptree& pt_config,
 			const boost::property_tree::ptree& pt_disease,
 			const boost::property_tree::ptree& pt_pop,
-			util::Random& rng);
+			util::Random& rng, Parallel& parallel);
 
 private:
 	/// Get distribution associateed with tag values.
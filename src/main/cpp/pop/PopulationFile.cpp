@@ -0,0 +1,135 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Implementation of the PopulationFile class.
+ */
+
+#include "PopulationFile.h"
+
+#include "util/StringUtils.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace stride {
+
+using namespace std;
+using namespace boost::interprocess;
+using namespace stride::util;
+
+namespace {
+
+const char g_magic[8] = {'S', 'T', 'R', 'I', 'D', 'E', 'P', 'B'};
+
+const uint32_t g_flag_risk_averseness = 1U;
+
+const size_t g_num_columns = static_cast<size_t>(PopulationFile::Column::Null);
+
+}
+
+PopulationFile::PopulationFile(const string& file_name)
+		: m_size(0U), m_columns(nullptr), m_risk_averseness(nullptr) {
+	try {
+		m_file = file_mapping(file_name.c_str(), read_only);
+		m_region = mapped_region(m_file, read_only);
+	} catch (interprocess_exception& e) {
+		throw runtime_error(string(__func__) + "> Error mapping population file " + file_name + ": " + e.what());
+	}
+
+	const auto data = static_cast<const char*>(m_region.get_address());
+	const size_t file_size = m_region.get_size();
+	Header header;
+	if (file_size < sizeof(Header)) {
+		throw runtime_error(string(__func__) + "> Population file " + file_name + " is too small.");
+	}
+	memcpy(&header, data, sizeof(Header));
+	if (memcmp(header.magic, g_magic, sizeof(g_magic)) != 0) {
+		throw runtime_error(string(__func__) + "> " + file_name + " is not a binary population file.");
+	}
+	if (header.version != version()) {
+		throw runtime_error(string(__func__) + "> Population file " + file_name + " has version "
+							+ to_string(header.version) + ", expected " + to_string(version()) + ".");
+	}
+
+	m_size = header.size;
+	const bool has_risk_averseness = (header.flags & g_flag_risk_averseness) != 0U;
+	const size_t columns_size = g_num_columns * m_size * sizeof(uint32_t);
+	if (file_size != sizeof(Header) + columns_size + (has_risk_averseness ? m_size * sizeof(double) : 0U)) {
+		throw runtime_error(string(__func__) + "> Population file " + file_name + " has the wrong size.");
+	}
+	m_columns = reinterpret_cast<const uint32_t*>(data + sizeof(Header));
+	if (has_risk_averseness) {
+		m_risk_averseness = reinterpret_cast<const double*>(data + sizeof(Header) + columns_size);
+	}
+}
+
+string PopulationFile::makeHeader(size_t size, bool has_risk_averseness) {
+	Header header;
+	memcpy(header.magic, g_magic, sizeof(g_magic));
+	header.version = version();
+	header.flags = has_risk_averseness ? g_flag_risk_averseness : 0U;
+	header.size = size;
+	return string(reinterpret_cast<const char*>(&header), sizeof(Header));
+}
+
+void PopulationFile::convert(const string& csv_file_name, const string& binary_file_name) {
+	ifstream csv_file(csv_file_name);
+	if (!csv_file.is_open()) {
+		throw runtime_error(string(__func__) + "> Error opening population file " + csv_file_name);
+	}
+
+	array<vector<uint32_t>, g_num_columns> columns;
+	vector<double> risk_averseness;
+	string line;
+	getline(csv_file, line); // step over file header
+	while (getline(csv_file, line)) {
+		const auto values = StringUtils::split(line, ",");
+		if (values.size() < g_num_columns) {
+			throw runtime_error(string(__func__) + "> Bad line in population file " + csv_file_name + ": " + line);
+		}
+		for (size_t c = 0; c < g_num_columns; c++) {
+			columns[c].push_back(StringUtils::fromString<unsigned int>(values[c]));
+		}
+		risk_averseness.push_back(values.size() > 6 ? StringUtils::fromString<double>(values[6]) : 0.0);
+	}
+
+	// The risk averseness is only stored when it is used (as when reading the csv).
+	bool has_risk_averseness = false;
+	for (const auto r: risk_averseness) {
+		has_risk_averseness = has_risk_averseness || r != 0.0;
+	}
+
+	ofstream binary_file(binary_file_name, ios::binary | ios::trunc);
+	if (!binary_file.is_open()) {
+		throw runtime_error(string(__func__) + "> Error opening population file " + binary_file_name);
+	}
+	binary_file << makeHeader(risk_averseness.size(), has_risk_averseness);
+	for (const auto& column: columns) {
+		binary_file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(uint32_t));
+	}
+	if (has_risk_averseness) {
+		binary_file.write(reinterpret_cast<const char*>(risk_averseness.data()), risk_averseness.size() * sizeof(double));
+	}
+	if (!binary_file) {
+		throw runtime_error(string(__func__) + "> Error writing population file " + binary_file_name);
+	}
+}
+
+}
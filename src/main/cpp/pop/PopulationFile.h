@@ -0,0 +1,85 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Header for the PopulationFile class.
+ */
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stride {
+
+/**
+ * Binary population file: the people of a population in fixed-width columns, so it can be
+ * mapped into memory and read without parsing. The layout (native byte order) is
+ * \li a header: "STRIDEPB", the format version, flags and the number of people
+ * \li the columns age, household, school, work, primary and secondary community (uint32 each)
+ * \li the risk averseness (double), if the flags say so.
+ *
+ * Use convert to make one out of a people file (csv), or makeHeader to write one directly.
+ */
+class PopulationFile {
+public:
+	/// The uint32 columns, in the order of the file (and of the csv).
+	enum class Column {
+		Age = 0U, Household, School, Work, PrimaryCommunity, SecondaryCommunity, Null
+	};
+
+	/// Map the given binary population file.
+	explicit PopulationFile(const std::string& file_name);
+
+	/// Number of people in the file.
+	std::size_t size() const { return m_size; }
+
+	/// Get the given column (size() values).
+	const std::uint32_t* getColumn(Column column) const {
+		return m_columns + static_cast<std::size_t>(column) * m_size;
+	}
+
+	/// Get the risk averseness of the people (nullptr if the file has none).
+	const double* getRiskAverseness() const { return m_risk_averseness; }
+
+	/// Write the people file (csv) with the given name as a binary population file.
+	static void convert(const std::string& csv_file_name, const std::string& binary_file_name);
+
+	/// The header of a file of size people, the columns have to follow (and the risk averseness, if it is there).
+	static std::string makeHeader(std::size_t size, bool has_risk_averseness);
+
+	/// Version of the format that is written.
+	static constexpr std::uint32_t version() { return 1U; }
+
+private:
+	/// Fixed part at the start of the file.
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t flags;           ///< Bit 0: has risk averseness.
+		std::uint64_t size;            ///< Number of people.
+	};
+
+	boost::interprocess::file_mapping m_file;      ///< The file.
+	boost::interprocess::mapped_region m_region;   ///< The whole file, mapped read-only.
+	std::size_t m_size;                            ///< Number of people.
+	const std::uint32_t* m_columns;                ///< Start of the uint32 columns.
+	const double* m_risk_averseness;               ///< Start of the risk averseness (or nullptr).
+};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Header for the PopulationStats class.
+ */
+
+#include "core/Health.h"
+
+#include <array>
+#include <cstddef>
+
+namespace stride {
+
+/**
+ * Snapshot of the number of persons in a population by health status, and of the number
+ * of persons who adopted the belief. Only the persons present in the region are counted
+ * (persons on vacation are counted by the region they visit).
+ */
+class PopulationStats {
+public:
+	using Counts = std::array<unsigned int, static_cast<std::size_t>(HealthStatus::Null)>;
+
+	PopulationStats(const Counts& counts, unsigned int adopted)
+			: m_counts(counts), m_adopted(adopted) {}
+
+	/// Number of persons with the given health status.
+	unsigned int getCount(HealthStatus status) const { return m_counts[static_cast<std::size_t>(status)]; }
+
+	/// Cumulative number of cases (infected or recovered).
+	unsigned int getInfectedCount() const {
+		return getCount(HealthStatus::Exposed) + getCount(HealthStatus::Infectious)
+			   + getCount(HealthStatus::Symptomatic) + getCount(HealthStatus::InfectiousAndSymptomatic)
+			   + getCount(HealthStatus::Recovered);
+	}
+
+	/// Number of persons present (everyone has a health status).
+	unsigned int getPresentCount() const {
+		unsigned int total = 0U;
+		for (const auto count: m_counts) {
+			total += count;
+		}
+		return total;
+	}
+
+	/// Fraction of the persons present that is or has been infected (the cases and the
+	/// population they are part of are counted alike, without the persons on vacation).
+	double getFractionInfected() const {
+		const unsigned int present = getPresentCount();
+		return present == 0U ? 0.0 : static_cast<double>(getInfectedCount()) / present;
+	}
+
+	/// Number of persons who adopted the belief.
+	unsigned int getAdoptedCount() const { return m_adopted; }
+
+private:
+	Counts m_counts;         ///< Number of persons by health status.
+	unsigned int m_adopted;  ///< Number of persons who adopted the belief.
+};
+
+}
@@ -0,0 +1,163 @@
+#include "popgen/ChunkedWriter.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+#ifdef ZLIB_USED
+#include <zlib.h>
+#endif
+
+using namespace stride;
+using namespace popgen;
+
+namespace {
+
+/// Size of a chunk (bytes).
+const size_t g_chunk_size = 1U << 20;
+
+/// Chunks that may wait for the writer thread.
+const size_t g_max_waiting_chunks = 4U;
+
+}
+
+ChunkedWriter::ChunkedWriter(const string& file_name, bool compress)
+		: m_file_name(file_name), m_gz_file(nullptr), m_precision(6), m_stop(false), m_failed(false) {
+	if (compress) {
+#ifdef ZLIB_USED
+		m_gz_file = gzopen(file_name.c_str(), "wb");
+		if (m_gz_file == nullptr) {
+			throw runtime_error(string(__func__) + "> Could not open " + file_name);
+		}
+#else
+		throw runtime_error(string(__func__) + "> Compressed output needs zlib, which was not found at build time.");
+#endif
+	} else {
+		m_file.open(file_name, ios::binary | ios::trunc);
+		if (!m_file.is_open()) {
+			throw runtime_error(string(__func__) + "> Could not open " + file_name);
+		}
+	}
+	m_chunk.reserve(g_chunk_size);
+	m_thread = thread(&ChunkedWriter::writeChunks, this);
+}
+
+ChunkedWriter::~ChunkedWriter() {
+	if (m_thread.joinable()) {
+		finish();
+	}
+}
+
+void ChunkedWriter::write(const char* data, size_t size) {
+	m_chunk.append(data, size);
+	if (m_chunk.size() >= g_chunk_size) {
+		submit();
+	}
+}
+
+ChunkedWriter& ChunkedWriter::operator<<(const char* text) {
+	write(text, char_traits<char>::length(text));
+	return *this;
+}
+
+ChunkedWriter& ChunkedWriter::operator<<(unsigned long value) {
+	char digits[20];
+	size_t count = 0;
+	do {
+		digits[sizeof(digits) - ++count] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	write(digits + sizeof(digits) - count, count);
+	return *this;
+}
+
+ChunkedWriter& ChunkedWriter::operator<<(int value) {
+	if (value < 0) {
+		*this << '-';
+		return *this << -static_cast<unsigned long>(static_cast<long>(value));
+	}
+	return *this << static_cast<unsigned long>(value);
+}
+
+ChunkedWriter& ChunkedWriter::operator<<(double value) {
+	// An ostream with the default floatfield formats as %g.
+	char text[64];
+	const int size = snprintf(text, sizeof(text), "%.*g", m_precision, value);
+	write(text, static_cast<size_t>(size));
+	return *this;
+}
+
+void ChunkedWriter::close() {
+	if (!m_thread.joinable()) {
+		return;
+	}
+	if (!finish()) {
+		throw runtime_error(string(__func__) + "> Error writing " + m_file_name);
+	}
+}
+
+void ChunkedWriter::submit() {
+	unique_lock<mutex> lock(m_mutex);
+	m_room.wait(lock, [this]() { return m_chunks.size() < g_max_waiting_chunks; });
+	m_chunks.push_back(std::move(m_chunk));
+	lock.unlock();
+	m_wake.notify_one();
+
+	m_chunk = string();
+	m_chunk.reserve(g_chunk_size);
+}
+
+void ChunkedWriter::writeChunks() {
+	while (true) {
+		string chunk;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_stop || !m_chunks.empty(); });
+			if (m_chunks.empty()) {
+				return;
+			}
+			chunk = std::move(m_chunks.front());
+			m_chunks.pop_front();
+		}
+		m_room.notify_one();
+
+		bool written = true;
+		if (m_gz_file != nullptr) {
+#ifdef ZLIB_USED
+			written = gzwrite(m_gz_file, chunk.data(), static_cast<unsigned int>(chunk.size()))
+					  == static_cast<int>(chunk.size());
+#endif
+		} else {
+			m_file.write(chunk.data(), chunk.size());
+			written = m_file.good();
+		}
+		if (!written) {
+			lock_guard<mutex> lock(m_mutex);
+			m_failed = true;
+		}
+	}
+}
+
+bool ChunkedWriter::finish() {
+	if (!m_chunk.empty()) {
+		submit();
+	}
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+
+	bool closed = true;
+	if (m_gz_file != nullptr) {
+#ifdef ZLIB_USED
+		closed = gzclose(m_gz_file) == Z_OK;
+#endif
+		m_gz_file = nullptr;
+	} else {
+		m_file.close();
+		closed = !m_file.fail();
+	}
+	return closed && !m_failed;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct gzFile_s;
+
+namespace stride {
+namespace popgen {
+
+using namespace std;
+
+/**
+ * Output file of the population generator. The lines are formatted into a chunk in memory, a full chunk
+ * goes to a thread that writes it to the file (compressed with gzip, if asked) while the next one is filled.
+ * At most a few chunks wait, so the memory use does not grow with the file.
+ * Numbers are formatted as by an ostream (the precision of the doubles is set with precision).
+ */
+class ChunkedWriter {
+public:
+	/// Opens the file, with compress the content is written with gzip (throws if built without zlib).
+	explicit ChunkedWriter(const string& file_name, bool compress = false);
+
+	/// Closes the file, if that was not done yet (errors are lost then, see close).
+	~ChunkedWriter();
+
+	ChunkedWriter(const ChunkedWriter&) = delete;
+	ChunkedWriter& operator=(const ChunkedWriter&) = delete;
+
+	/// Write the given bytes as they are.
+	void write(const char* data, size_t size);
+
+	/// The number of significant digits of the doubles that are written next (6 at first, as for an ostream).
+	void precision(int digits) { m_precision = digits; }
+
+	ChunkedWriter& operator<<(const char* text);
+
+	ChunkedWriter& operator<<(const string& text) {
+		write(text.data(), text.size());
+		return *this;
+	}
+
+	ChunkedWriter& operator<<(char c) {
+		write(&c, 1U);
+		return *this;
+	}
+
+	ChunkedWriter& operator<<(unsigned long value);
+
+	ChunkedWriter& operator<<(unsigned int value) { return *this << static_cast<unsigned long>(value); }
+
+	ChunkedWriter& operator<<(int value);
+
+	ChunkedWriter& operator<<(double value);
+
+	/// Write what is left and close the file, throws if anything could not be written.
+	void close();
+
+private:
+	/// Hand the current chunk to the writer thread (waits while too many chunks are waiting).
+	void submit();
+
+	/// Body of the writer thread.
+	void writeChunks();
+
+	/// Stop the thread (after the chunks that are waiting) and close the file, returns false on errors.
+	bool finish();
+
+private:
+	string m_file_name;
+	ofstream m_file;
+	gzFile_s* m_gz_file;                ///< The file when compressing (nullptr otherwise).
+	string m_chunk;                     ///< The chunk that is being filled.
+	int m_precision;
+
+	mutex m_mutex;                      ///< Guards the queue, m_stop and m_failed.
+	condition_variable m_wake;          ///< A chunk is waiting, or the thread has to stop.
+	condition_variable m_room;          ///< A chunk has been written.
+	deque<string> m_chunks;
+	bool m_stop;
+	bool m_failed;
+	thread m_thread;
+};
+
+}
+}
@@ -0,0 +1,85 @@
+#include "popgen/DistanceMap.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace stride;
+using namespace popgen;
+
+DistanceMap::DistanceMap() : m_radius(0.0), m_factor(2.0) {}
+
+DistanceMap::DistanceMap(const vector<GeoCoordinate>& locations, double radius, double factor)
+		: m_radius(radius), m_factor(factor), m_location_of_cluster(locations.size()) {
+	if (radius <= 0.0 || factor <= 1.0) {
+		throw invalid_argument(string(__func__) + "> The rings need a positive radius and a factor above 1.");
+	}
+	map<GeoCoordinate, uint> location_ids;
+	vector<GeoCoordinate> distinct_locations;
+	for (uint i = 0; i < locations.size(); i++) {
+		const auto inserted = location_ids.insert(make_pair(locations[i], uint(distinct_locations.size())));
+		if (inserted.second) {
+			distinct_locations.push_back(locations[i]);
+			m_clusters.emplace_back();
+		}
+		m_location_of_cluster[i] = inserted.first->second;
+		m_clusters[inserted.first->second].push_back(i);
+	}
+	m_grid = GeoGrid(distinct_locations);
+}
+
+vector<uint> DistanceMap::getClustersWithinRange(double radius, const GeoCoordinate& coordinate) const {
+	vector<uint> result;
+	if (radius < m_radius || m_clusters.empty()) {
+		return result;
+	}
+	double ring_radius = m_radius;
+	while (ring_radius * m_factor <= radius) {
+		ring_radius *= m_factor;
+	}
+
+	vector<uint> locations;
+	vector<double> distances;
+	m_grid.findWithin(coordinate, ring_radius, locations, distances);
+
+	// The ring of a location is the first one that holds it.
+	vector<uint> rings(locations.size());
+	uint num_rings = 0;
+	for (uint i = 0; i < locations.size(); i++) {
+		uint ring = 0;
+		for (double current_radius = m_radius; distances[i] > current_radius; current_radius *= m_factor) {
+			ring++;
+		}
+		rings[i] = ring;
+		num_rings = max(num_rings, ring + 1);
+	}
+
+	// The locations are in increasing order, so collecting them ring by ring keeps that order in a ring.
+	for (uint ring = 0; ring < num_rings; ring++) {
+		const size_t ring_start = result.size();
+		uint ring_locations = 0;
+		for (uint i = 0; i < locations.size(); i++) {
+			if (rings[i] == ring) {
+				const auto& clusters = m_clusters[locations[i]];
+				result.insert(result.end(), clusters.begin(), clusters.end());
+				ring_locations++;
+			}
+		}
+		if (ring_locations > 1) {
+			sort(result.begin() + ring_start, result.end());
+		}
+	}
+	return result;
+}
+
+bool DistanceMap::remove(uint index) {
+	auto& clusters = m_clusters[m_location_of_cluster.at(index)];
+	const auto it = lower_bound(clusters.begin(), clusters.end(), index);
+	if (it == clusters.end() || *it != index) {
+		return false;
+	}
+	clusters.erase(it);
+	return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "util/GeoCoordinate.h"
+#include "util/GeoGrid.h"
+
+namespace stride {
+namespace popgen {
+
+using namespace std;
+using namespace util;
+
+using uint = unsigned int;
+
+/**
+ * The clusters of one kind (schools, workplaces, ...) by location, for finding the clusters near a person.
+ * Distances are measured in rings: radius, radius * factor, radius * factor^2, ...
+ * The clusters share a few locations (the cities and villages), the locations are in a spatial grid and
+ * every location holds the indices of its clusters, so a full cluster is removed at one place.
+ */
+class DistanceMap {
+public:
+	/// No clusters.
+	DistanceMap();
+
+	/// The clusters (indices in the vector) at the given locations.
+	DistanceMap(const vector<GeoCoordinate>& locations, double radius, double factor);
+
+	/// The clusters within the largest ring that is not larger than the given radius, the ones in the
+	/// inner rings first, in increasing order within a ring (empty if the radius is smaller than the first ring).
+	vector<uint> getClustersWithinRange(double radius, const GeoCoordinate& coordinate) const;
+
+	/// Remove a (full) cluster, returns false if it was removed already.
+	bool remove(uint index);
+
+private:
+	double m_radius;                     ///< The first ring.
+	double m_factor;
+	GeoGrid m_grid;                      ///< The distinct locations.
+	vector<vector<uint>> m_clusters;     ///< The clusters that are left, by location (in increasing order).
+	vector<uint> m_location_of_cluster;
+};
+
+}
+}
@@ -1,5 +1,7 @@
 #include "PopulationGenerator.h"
+#include "ChunkedWriter.h"
 #include "FamilyParser.h"
+#include "pop/PopulationFile.h"
 #include "util/InstallDirs.h"
 #include "util/TimeStamp.h"
 
@@ -14,8 +16,15 @@ using namespace util;
 using namespace boost::property_tree;
 using namespace xml_parser;
 
+namespace {
+
+/// The number of households or people in a partition of the parallel mode (independent of the number of threads)
+const uint g_partition_size = 10000U;
+
+}
+
 template<class U>
-PopulationGenerator<U>::PopulationGenerator(const string& filename, const int& seed, bool output) {
+PopulationGenerator<U>::PopulationGenerator(const string& filename, const int& seed, bool output, uint num_threads) {
 	// check data environment.
 	if (InstallDirs::getDataDir().empty()) {
 		throw runtime_error(string(__func__) + "> Data directory not present! Aborting.");
@@ -45,12 +54,14 @@ PopulationGenerator<U>::PopulationGenerator(const string& filename, const int& s
 	m_next_id = 1;
 	m_output = output;
 	m_rng = U(seed);
+	m_seed = seed;
+	m_num_threads = num_threads;
 
 	checkForValidXML();
 }
 
 template<class U>
-void PopulationGenerator<U>::generate(const string& prefix) {
+void PopulationGenerator<U>::generate(const string& prefix, bool compress, bool binary) {
 
 	if (m_output) cerr << "Generating " << m_total << " people...\n";
 
@@ -62,38 +73,52 @@ void PopulationGenerator<U>::generate(const string& prefix) {
 	makeUniversities();
 	makeWork();
 	makeCommunities();
-	assignToSchools();
-	assignToUniversities();
-	assignToWork();
 
-	double start_radius = m_props.get<double>("population.commutingdata.<xmlattr>.start_radius");
-	double factor = m_props.get<double>("population.commutingdata.<xmlattr>.factor");
+	if (m_num_threads == 0) {
+		assignToSchools();
+		assignToUniversities(m_rng);
+		assignToWork(m_rng);
+
+		double start_radius = m_props.get<double>("population.commutingdata.<xmlattr>.start_radius");
+		double factor = m_props.get<double>("population.commutingdata.<xmlattr>.factor");
 
-	vector<pair<GeoCoordinate, map<double, vector<uint>>>> distance_map = makeDistanceMap(start_radius, factor,
-																						  m_primary_communities);
-	assignToCommunities(distance_map, m_primary_communities, &SimplePerson::m_primary_community, "primary communities");
+		DistanceMap distance_map = makeDistanceMap(start_radius, factor, m_primary_communities);
+		assignToCommunities(distance_map, m_primary_communities, &SimplePerson::m_primary_community, m_rng,
+							"primary communities");
 
-	distance_map.clear();
-	distance_map = makeDistanceMap(start_radius, factor, m_secondary_communities);
-	assignToCommunities(distance_map, m_secondary_communities, &SimplePerson::m_secondary_community,
-						"secondary communities");
+		distance_map = makeDistanceMap(start_radius, factor, m_secondary_communities);
+		assignToCommunities(distance_map, m_secondary_communities, &SimplePerson::m_secondary_community, m_rng,
+							"secondary communities");
+	} else {
+		assignInParallel();
+	}
 
 	if (m_output) cerr << "Generated " << m_people.size() << " people\n";
 
+	// The summary refers to the csv files by the names they get once unpacked (gunzip only drops the
+	// extension), since Stride reads uncompressed files only.
 	string target_cities = prefix + "_districts.csv";
-	string target_pop = prefix + "_people.csv";
+	string target_pop = prefix + "_people" + (binary ? ".bin" : ".csv");
 	string target_households = prefix + "_households.csv";
 	string target_clusters = prefix + "_clusters.csv";
 	string target_summary = prefix + ".xml";
+	const string gz_extension = compress ? ".gz" : "";
 
-	writeCities(target_cities);
-	writePop(target_pop);
-	writeHouseholds(target_households);
-	writeClusters(target_clusters);
+	writeCities(target_cities + gz_extension, compress);
+	if (binary) {
+		writePopBinary(target_pop);
+	} else {
+		writePop(target_pop + gz_extension, compress);
+	}
+	writeHouseholds(target_households + gz_extension, compress);
+	writeClusters(target_clusters + gz_extension, compress);
 
 	// Now write a summary
 	ptree config;
 	config.put("population.people", target_pop);
+	if (binary) {
+		config.put("population.format", "binary");
+	}
 	config.put("population.districts", target_cities);
 	config.put("population.clusters", target_clusters);
 	config.put("population.households", target_households);
@@ -103,8 +128,55 @@ void PopulationGenerator<U>::generate(const string& prefix) {
 }
 
 template<class U>
-void PopulationGenerator<U>::writeCities(const string& target_cities) {
-	ofstream my_file {(InstallDirs::getDataDir() /= target_cities).string()};
+void PopulationGenerator<U>::assignInParallel() {
+	assignToSchools();
+
+	// Every person belongs to one university or school, one workplace and one community of each kind,
+	// so the three tasks below write different members of the people (and use different clusters).
+	// Progress per person from several threads would be unreadable, so it is turned off meanwhile.
+	const bool output = m_output;
+	if (m_output) cerr << "Assigning people to universities, workplaces and communities (" << m_num_threads
+					   << " threads)...\n";
+	m_output = false;
+
+	double start_radius = m_props.get<double>("population.commutingdata.<xmlattr>.start_radius");
+	double factor = m_props.get<double>("population.commutingdata.<xmlattr>.factor");
+
+	Parallel parallel(static_cast<int>(m_num_threads));
+	parallel.dynamicFor_(0U, 3U, [&](size_t task) {
+		if (task == 0) {
+			U rng = makeRng(Stream::UniversitiesWork, 0U);
+			assignToUniversities(rng);
+			assignToWork(rng);
+		} else if (task == 1) {
+			U rng = makeRng(Stream::PrimaryCommunities, 0U);
+			DistanceMap distance_map = makeDistanceMap(start_radius, factor, m_primary_communities);
+			assignToCommunities(distance_map, m_primary_communities, &SimplePerson::m_primary_community, rng);
+		} else {
+			U rng = makeRng(Stream::SecondaryCommunities, 0U);
+			DistanceMap distance_map = makeDistanceMap(start_radius, factor, m_secondary_communities);
+			assignToCommunities(distance_map, m_secondary_communities, &SimplePerson::m_secondary_community, rng);
+		}
+	});
+
+	m_output = output;
+}
+
+template<class U>
+uint PopulationGenerator<U>::countAges(uint min_age, uint max_age) const {
+	uint total = 0;
+	for (uint age = min_age; age <= max_age; age++) {
+		const auto it = m_age_distribution.find(age);
+		if (it != m_age_distribution.end()) {
+			total += it->second;
+		}
+	}
+	return total;
+}
+
+template<class U>
+void PopulationGenerator<U>::writeCities(const string& target_cities, bool compress) {
+	ChunkedWriter my_file {(InstallDirs::getDataDir() /= target_cities).string(), compress};
 	double total_pop = 0.0;
 
 	for (const SimpleCity& city: m_cities) {
@@ -115,133 +187,143 @@ void PopulationGenerator<U>::writeCities(const string& target_cities) {
 		total_pop += village.m_current_size;
 	}
 
-	if (my_file.is_open()) {
-		my_file
-				<< "\"city_id\",\"city_name\",\"province\",\"population\",\"x_coord\",\"y_coord\",\"latitude\",\"longitude\"\n";
-
-		uint provinces = m_props.get<uint>("population.<xmlattr>.provinces");
-		AliasDistribution dist {vector<double>(provinces, 1.0 / provinces)};
-
-		auto printCityData = [&](const SimpleCity& to_print) {
-			my_file << to_print.m_current_size / total_pop
-					<< ",0,0,"
-					<< to_print.m_coord.m_latitude
-					<< ","
-					<< to_print.m_coord.m_longitude
-					<< endl;
-		};
-
-		auto printVillageData = [&](const SimpleCluster& to_print) {
-			SimpleCity city = SimpleCity(to_print.m_current_size, to_print.m_max_size, to_print.m_id, "",
-										 to_print.m_coord);
-			printCityData(city);
-		};
-
-		for (const SimpleCity& city: m_cities) {
-			my_file.precision(std::numeric_limits<double>::max_digits10);
-			my_file << city.m_id
-					<< ",\""
-					<< city.m_name
-					<< "\"," << dist(m_rng) + 1 << ",";
-			printCityData(city);
-		}
+	my_file << "\"city_id\",\"city_name\",\"province\",\"population\",\"x_coord\",\"y_coord\",\"latitude\",\"longitude\"\n";
 
-		uint village_counter = 1;
-		for (const SimpleCluster& village: m_villages) {
-			my_file.precision(std::numeric_limits<double>::max_digits10);
-			my_file << village.m_id
-					<< ",\""
-					<< village_counter
-					<< "\"," << dist(m_rng) + 1 << ",";
+	uint provinces = m_props.get<uint>("population.<xmlattr>.provinces");
+	AliasDistribution dist {vector<double>(provinces, 1.0 / provinces)};
 
-			printVillageData(village);
-			village_counter++;
-		}
+	auto printCityData = [&](const SimpleCity& to_print) {
+		my_file << to_print.m_current_size / total_pop
+				<< ",0,0,"
+				<< to_print.m_coord.m_latitude
+				<< ","
+				<< to_print.m_coord.m_longitude
+				<< '\n';
+	};
 
-		my_file.close();
-		if (m_output) cout << "Written " << target_cities << endl;
-	} else {
-		throw invalid_argument("In PopulationGenerator: Invalid file.");
+	auto printVillageData = [&](const SimpleCluster& to_print) {
+		SimpleCity city = SimpleCity(to_print.m_current_size, to_print.m_max_size, to_print.m_id, "",
+									 to_print.m_coord);
+		printCityData(city);
+	};
+
+	my_file.precision(std::numeric_limits<double>::max_digits10);
+	for (const SimpleCity& city: m_cities) {
+		my_file << city.m_id
+				<< ",\""
+				<< city.m_name
+				<< "\"," << dist(m_rng) + 1 << ",";
+		printCityData(city);
 	}
+
+	uint village_counter = 1;
+	for (const SimpleCluster& village: m_villages) {
+		my_file << village.m_id
+				<< ",\""
+				<< village_counter
+				<< "\"," << dist(m_rng) + 1 << ",";
+
+		printVillageData(village);
+		village_counter++;
+	}
+
+	my_file.close();
+	if (m_output) cout << "Written " << target_cities << endl;
 }
 
 template<class U>
-void PopulationGenerator<U>::writePop(const string& target_pop) const {
-	ofstream my_file {(InstallDirs::getDataDir() /= target_pop).string()};
+void PopulationGenerator<U>::writePop(const string& target_pop, bool compress) const {
+	ChunkedWriter my_file {(InstallDirs::getDataDir() /= target_pop).string(), compress};
+	my_file << "\"age\",\"household_id\",\"school_id\",\"work_id\",\"primary_community\",\"secondary_community\"\n";
+
+	for (const SimplePerson& person: m_people) {
+		my_file << person.m_age << ","
+				<< person.m_household_id << ","
+				<< person.m_school_id << ","
+				<< person.m_work_id << ","
+				<< person.m_primary_community << ","
+				<< person.m_secondary_community
+				<< '\n';
+	}
 
-	if (my_file.is_open()) {
-		my_file << "\"age\",\"household_id\",\"school_id\",\"work_id\",\"primary_community\",\"secondary_community\"\n";
+	my_file.close();
+	if (m_output) cout << "Written " << target_pop << endl;
+}
 
+template<class U>
+void PopulationGenerator<U>::writePopBinary(const string& target_pop) const {
+	ChunkedWriter my_file {(InstallDirs::getDataDir() /= target_pop).string()};
+	my_file << PopulationFile::makeHeader(m_people.size(), false);
+
+	// The columns in the order of PopulationFile::Column.
+	vector<uint SimplePerson::*> columns {&SimplePerson::m_age,
+										  &SimplePerson::m_household_id,
+										  &SimplePerson::m_school_id,
+										  &SimplePerson::m_work_id,
+										  &SimplePerson::m_primary_community,
+										  &SimplePerson::m_secondary_community};
+
+	for (auto column: columns) {
 		for (const SimplePerson& person: m_people) {
-			my_file << person.m_age << ","
-					<< person.m_household_id << ","
-					<< person.m_school_id << ","
-					<< person.m_work_id << ","
-					<< person.m_primary_community << ","
-					<< person.m_secondary_community
-					<< endl;
+			const uint32_t value = person.*column;
+			my_file.write(reinterpret_cast<const char*>(&value), sizeof(value));
 		}
-
-		my_file.close();
-		if (m_output) cout << "Written " << target_pop << endl;
-	} else {
-		throw invalid_argument("In PopulationGenerator: Invalid file.");
 	}
+
+	my_file.close();
+	if (m_output) cout << "Written " << target_pop << endl;
 }
 
 template<class U>
-void PopulationGenerator<U>::writeHouseholds(const string& target_households) const {
-	ofstream my_file {(InstallDirs::getDataDir() /= target_households).string()};
-	if (my_file.is_open()) {
-		my_file << "\"hh_id\",\"latitude\",\"longitude\",\"size\"\n";
-
-		for (const SimpleHousehold& household: m_households) {
-			my_file << household.m_id << ","
-					<< m_people.at(household.m_indices.at(0)).m_coord.m_latitude << ","
-					<< m_people.at(household.m_indices.at(0)).m_coord.m_longitude << ","
-					<< household.m_indices.size()
-					<< endl;
-		}
-
-		my_file.close();
-		if (m_output) cout << "Written " << target_households << endl;
-	} else {
-		throw invalid_argument("In PopulationGenerator: Invalid file.");
+void PopulationGenerator<U>::writeHouseholds(const string& target_households, bool compress) const {
+	ChunkedWriter my_file {(InstallDirs::getDataDir() /= target_households).string(), compress};
+	my_file << "\"hh_id\",\"latitude\",\"longitude\",\"size\"\n";
+
+	for (const SimpleHousehold& household: m_households) {
+		const auto& coord = m_people.at(household.m_indices.at(0)).m_coord;
+		my_file << household.m_id << ","
+				<< coord.m_latitude << ","
+				<< coord.m_longitude << ","
+				<< household.m_indices.size()
+				<< '\n';
 	}
+
+	my_file.close();
+	if (m_output) cout << "Written " << target_households << endl;
 }
 
 template<class U>
-void PopulationGenerator<U>::writeClusters(const string& target_clusters) const {
-	ofstream my_file {(InstallDirs::getDataDir() /= target_clusters).string()};
-	if (my_file.is_open()) {
-		my_file << "\"cluster_id\",\"cluster_type\",\"latitude\",\"longitude\"\n";
-
-		vector<ClusterType> types {ClusterType::Household,
-								   ClusterType::School,
-								   ClusterType::Work,
-								   ClusterType::PrimaryCommunity,
-								   ClusterType::SecondaryCommunity,
-								   ClusterType::Null};
-
-		for (auto& cluster_type: types) {
-			uint current_id = 1;
-			while (m_locations.find(make_pair(cluster_type, current_id)) != m_locations.end()) {
-				my_file.precision(std::numeric_limits<double>::max_digits10);
-				my_file << current_id << ","
-						<< toString(cluster_type) << ","
-						<< m_locations.at(make_pair(cluster_type, current_id)).m_latitude << ","
-						<< m_locations.at(make_pair(cluster_type, current_id)).m_longitude
-						<< endl;
-
-				++current_id;
-			}
+void PopulationGenerator<U>::writeClusters(const string& target_clusters, bool compress) const {
+	ChunkedWriter my_file {(InstallDirs::getDataDir() /= target_clusters).string(), compress};
+	my_file << "\"cluster_id\",\"cluster_type\",\"latitude\",\"longitude\"\n";
+	my_file.precision(std::numeric_limits<double>::max_digits10);
+
+	vector<ClusterType> types {ClusterType::Household,
+							   ClusterType::School,
+							   ClusterType::Work,
+							   ClusterType::PrimaryCommunity,
+							   ClusterType::SecondaryCommunity,
+							   ClusterType::Null};
+
+	for (auto& cluster_type: types) {
+		// The locations are ordered by type and ID: walk the IDs 1, 2, ... of this type until there is a gap.
+		const string type_name = toString(cluster_type);
+		uint current_id = 1;
+		auto it = m_locations.lower_bound(make_pair(cluster_type, current_id));
+		while (it != m_locations.end() && it->first == make_pair(cluster_type, current_id)) {
+			my_file << current_id << ","
+					<< type_name << ","
+					<< it->second.m_latitude << ","
+					<< it->second.m_longitude
+					<< '\n';
+
+			++current_id;
+			++it;
 		}
-
-		my_file.close();
-		if (m_output) cout << "Written " << target_clusters << endl;
-	} else {
-		throw invalid_argument("In PopulationGenerator: Invalid file.");
 	}
+
+	my_file.close();
+	if (m_output) cout << "Written " << target_clusters << endl;
 }
 
 template<class U>
@@ -642,11 +724,29 @@ void PopulationGenerator<U>::placeHouseholds() {
 	}
 
 	AliasDistribution village_city_dist {fractions};
-	int i = 0;
-	for (SimpleHousehold& household: m_households) {
-		if (m_output)
-			cerr << "\rPlacing households [" << min(uint(double(i) / m_households.size() * 100), 100U) << "%]";
-		uint index = village_city_dist(m_rng);
+	vector<uint> indices(m_households.size());
+	if (m_num_threads == 0) {
+		for (uint i = 0; i < m_households.size(); i++) {
+			if (m_output)
+				cerr << "\rPlacing households [" << min(uint(double(i) / m_households.size() * 100), 100U) << "%]";
+			indices[i] = village_city_dist(m_rng);
+		}
+	} else {
+		const uint num_partitions = (m_households.size() + g_partition_size - 1) / g_partition_size;
+		Parallel parallel(static_cast<int>(m_num_threads));
+		parallel.for_(0U, num_partitions, [&](size_t partition) {
+			U rng = makeRng(Stream::PlaceHouseholds, partition);
+			AliasDistribution dist = village_city_dist;
+			const size_t last = min(m_households.size(), (partition + 1) * g_partition_size);
+			for (size_t i = partition * g_partition_size; i < last; i++) {
+				indices[i] = dist(rng);
+			}
+		});
+	}
+
+	for (uint i = 0; i < m_households.size(); i++) {
+		SimpleHousehold& household = m_households[i];
+		const uint index = indices[i];
 		if (index < m_cities.size()) {
 			/// A city has been chosen
 			SimpleCity& city = m_cities.at(index);
@@ -665,7 +765,6 @@ void PopulationGenerator<U>::placeHouseholds() {
 			}
 			m_locations[make_pair(ClusterType::Household, household.m_id)] = village.m_coord;
 		}
-		i++;
 	}
 	if (m_output) cerr << "\rPlacing households [100%]...\n";
 }
@@ -850,49 +949,75 @@ void PopulationGenerator<U>::assignToSchools() {
 
 	double factor = m_props.get<double>("population.commutingdata.<xmlattr>.factor");
 
-	double current_radius = start_radius;
-
-	uint total = 0;
+	uint total = countAges(min_age, max_age);
 	uint total_placed = 0;
 
-	for (uint i = min_age; i <= max_age; i++) {
-		total += m_age_distribution[i];
-	}
-
 	auto distance_map = makeDistanceMap(start_radius, factor, m_mandatory_schools);
 
-	for (SimplePerson& person: m_people) {
-		current_radius = start_radius;
+	// A school only counts its children, so in the parallel mode every partition of the people chooses
+	// with its own random stream, and the counts are added up afterwards.
+	vector<pair<uint, uint>> schools(m_people.size());
+	if (m_num_threads == 0) {
+		for (uint i = 0; i < m_people.size(); i++) {
+			const SimplePerson& person = m_people[i];
+			if (person.m_age >= min_age && person.m_age <= max_age) {
+				if (m_output)
+					cerr << "\rAssigning children to schools [" << min(uint(double(total_placed) / total * 100), 100U)
+						 << "%]";
+				total_placed++;
+				schools[i] = chooseSchool(person, distance_map, start_radius, factor, m_rng);
+			}
+		}
+	} else {
+		const uint num_partitions = (m_people.size() + g_partition_size - 1) / g_partition_size;
+		Parallel parallel(static_cast<int>(m_num_threads));
+		parallel.for_(0U, num_partitions, [&](size_t partition) {
+			U rng = makeRng(Stream::Schools, partition);
+			const size_t last = min(m_people.size(), (partition + 1) * g_partition_size);
+			for (size_t i = partition * g_partition_size; i < last; i++) {
+				const SimplePerson& person = m_people[i];
+				if (person.m_age >= min_age && person.m_age <= max_age) {
+					schools[i] = chooseSchool(person, distance_map, start_radius, factor, rng);
+				}
+			}
+		});
+	}
+
+	for (uint i = 0; i < m_people.size(); i++) {
+		SimplePerson& person = m_people[i];
 		if (person.m_age >= min_age && person.m_age <= max_age) {
-			if (m_output)
-				cerr << "\rAssigning children to schools [" << min(uint(double(total_placed) / total * 100), 100U)
-					 << "%]";
-			total_placed++;
+			SimpleCluster& school = m_mandatory_schools_clusters.at(schools[i].first).at(schools[i].second);
+			school.m_current_size++;
+			person.m_school_id = school.m_id;
+		}
+	}
+	if (m_output) cerr << "\rAssigning children to schools [100%]...\n";
+}
 
-			vector<uint> closest_clusters_indices;
+template<class U>
+pair<uint, uint> PopulationGenerator<U>::chooseSchool(const SimplePerson& person, const DistanceMap& distance_map,
+													   double start_radius, double factor, U& rng) const {
+	double current_radius = start_radius;
+	vector<uint> closest_clusters_indices;
 
-			while (closest_clusters_indices.size() == 0 && m_mandatory_schools.size() != 0) {
-				closest_clusters_indices = getClustersWithinRange(current_radius, distance_map, person.m_coord);
-				current_radius *= factor;
-			}
+	while (closest_clusters_indices.size() == 0 && m_mandatory_schools.size() != 0) {
+		closest_clusters_indices = getClustersWithinRange(current_radius, distance_map, person.m_coord);
+		current_radius *= factor;
+	}
 
-			AliasDistribution cluster_dist {
-					vector<double>(closest_clusters_indices.size(), 1.0 / double(closest_clusters_indices.size()))};
-			uint index = closest_clusters_indices.at(cluster_dist(m_rng));
+	AliasDistribution cluster_dist {
+			vector<double>(closest_clusters_indices.size(), 1.0 / double(closest_clusters_indices.size()))};
+	uint index = closest_clusters_indices.at(cluster_dist(rng));
 
-			AliasDistribution inner_cluster_dist {vector<double>(m_mandatory_schools_clusters.at(index).size(),
-																 1.0 / m_mandatory_schools_clusters.at(index).size())};
-			uint index2 = inner_cluster_dist(m_rng);
+	AliasDistribution inner_cluster_dist {vector<double>(m_mandatory_schools_clusters.at(index).size(),
+														 1.0 / m_mandatory_schools_clusters.at(index).size())};
+	uint index2 = inner_cluster_dist(rng);
 
-			m_mandatory_schools_clusters.at(index).at(index2).m_current_size++;
-			person.m_school_id = m_mandatory_schools_clusters.at(index).at(index2).m_id;
-		}
-	}
-	if (m_output) cerr << "\rAssigning children to schools [100%]...\n";
+	return make_pair(index, index2);
 }
 
 template<class U>
-void PopulationGenerator<U>::assignToUniversities() {
+void PopulationGenerator<U>::assignToUniversities(U& rng) {
 	ptree school_work_config = m_props.get_child("population.school_work_profile.employable.young_employee");
 	ptree university_config = m_props.get_child("population.education.optional");
 	uint min_age = school_work_config.get<uint>("<xmlattr>.min");
@@ -904,28 +1029,24 @@ void PopulationGenerator<U>::assignToUniversities() {
 	AliasDistribution commute_dist {{commute_fraction, 1.0 - commute_fraction}};
 	AliasDistribution student_dist {{student_fraction, 1.0 - student_fraction}};
 
-	uint total = 0;
+	uint total = countAges(min_age, max_age);
 	uint total_placed = 0;
 
-	for (uint i = min_age; i <= max_age; i++) {
-		total += m_age_distribution[i];
-	}
-
 	auto distance_map = makeDistanceMap(radius, 2.0, m_optional_schools);
 
 	for (SimplePerson& person: m_people) {
-		if (person.m_age >= min_age && person.m_age <= max_age && student_dist(m_rng) == 0) {
+		if (person.m_age >= min_age && person.m_age <= max_age && student_dist(rng) == 0) {
 			if (m_output)
 				cerr << "\rAssigning students to universities [" << min(uint(double(total_placed) / total * 100), 100U)
 					 << "%]";
 			total_placed++;
 
-			if (commute_dist(m_rng) == 0) {
+			if (commute_dist(rng) == 0) {
 				/// Commuting student
 				assignCommutingStudent(person, distance_map);
 			} else {
 				/// Non-commuting student
-				assignCloseStudent(person, radius, distance_map);
+				assignCloseStudent(person, radius, distance_map, rng);
 			}
 		}
 	}
@@ -933,8 +1054,7 @@ void PopulationGenerator<U>::assignToUniversities() {
 }
 
 template<class U>
-void PopulationGenerator<U>::removeFromUniMap(vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map,
-											  uint index) const {
+void PopulationGenerator<U>::removeFromUniMap(DistanceMap& distance_map, uint index) const {
 	bool full_capacity = true;
 
 	for (uint curr_univ = index; curr_univ < m_optional_schools.size(); ++curr_univ) {
@@ -947,51 +1067,19 @@ void PopulationGenerator<U>::removeFromUniMap(vector<pair<GeoCoordinate, map<dou
 
 	/// Remove the university from the map if it is full
 	if (full_capacity) {
-		for (auto& coord_map_pair: distance_map) {
-			for (auto it = coord_map_pair.second.begin(); it != coord_map_pair.second.end(); ++it) {
-				auto& index_vector = it->second;
-
-				auto cluster_iterator = std::find(index_vector.begin(), index_vector.end(), index);
-
-				if (cluster_iterator != index_vector.end()) {
-					index_vector.erase(cluster_iterator, cluster_iterator + 1);
-
-					removeFromUniMap(distance_map, index);
-
-					return;
-				}
-
-			}
-		}
+		distance_map.remove(index);
 	}
 }
 
 template<class U>
-bool PopulationGenerator<U>::removeFromMap(vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map,
-										   uint index) const {
-
+bool PopulationGenerator<U>::removeFromMap(DistanceMap& distance_map, uint index) const {
 	// Remove this cluster from the distance map
-	for (auto& coord_map_pair: distance_map) {
-		for (auto it = coord_map_pair.second.begin(); it != coord_map_pair.second.end(); ++it) {
-			auto& index_vector = it->second;
-
-			auto cluster_iterator = std::find(index_vector.begin(), index_vector.end(), index);
-
-			if (cluster_iterator != index_vector.end()) {
-				index_vector.erase(cluster_iterator, cluster_iterator + 1);
-
-				removeFromMap(distance_map, index);
-				return true;
-			}
-		}
-	}
-
-	return false;
+	return distance_map.remove(index);
 }
 
 template<class U>
 void PopulationGenerator<U>::assignCommutingStudent(SimplePerson& person,
-													vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map) {
+													DistanceMap& distance_map) {
 	uint current_city = 0;
 	bool added = false;
 
@@ -1017,7 +1105,7 @@ void PopulationGenerator<U>::assignCommutingStudent(SimplePerson& person,
 
 template<class U>
 void PopulationGenerator<U>::assignCloseStudent(SimplePerson& person, double start_radius,
-												vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map) {
+												DistanceMap& distance_map, U& rng) {
 	double factor = m_props.get<double>("population.commutingdata.<xmlattr>.factor");
 	double current_radius = start_radius;
 	bool added = false;
@@ -1034,7 +1122,7 @@ void PopulationGenerator<U>::assignCloseStudent(SimplePerson& person, double sta
 			AliasDistribution dist {
 					vector<double>(closest_clusters_indices.size(), 1.0 / closest_clusters_indices.size())};
 
-			uint index = dist(m_rng);
+			uint index = dist(rng);
 			while (index < m_optional_schools.size() && !added) {
 
 				for (uint i = 0; i < m_optional_schools.at(index).size(); i++) {
@@ -1061,7 +1149,7 @@ void PopulationGenerator<U>::assignCloseStudent(SimplePerson& person, double sta
 }
 
 template<class U>
-void PopulationGenerator<U>::assignToWork() {
+void PopulationGenerator<U>::assignToWork(U& rng) {
 	ptree school_work_config = m_props.get_child("population.school_work_profile.employable");
 	ptree work_config = m_props.get_child("population.work");
 	uint min_age = school_work_config.get<uint>("young_employee.<xmlattr>.min");
@@ -1073,14 +1161,10 @@ void PopulationGenerator<U>::assignToWork() {
 	AliasDistribution unemployment_dist {{unemployment_rate, 1.0 - unemployment_rate}};
 	AliasDistribution commute_dist {{commute_fraction, 1.0 - commute_fraction}};
 
-	uint total = 0;
+	uint total = countAges(min_age, max_age);
 	uint total_placed = 0;
 	uint amount_full = 0;
 
-	for (uint i = min_age; i <= max_age; i++) {
-		total += m_age_distribution[i];
-	}
-
 	auto distance_map = makeDistanceMap(radius, 2.0, m_workplaces);
 
 	for (SimplePerson& person: m_people) {
@@ -1094,14 +1178,14 @@ void PopulationGenerator<U>::assignToWork() {
 				cerr << "\rAssigning people to workplaces [" << min(uint(double(total_placed) / total * 100), 100U)
 					 << "%]";
 			total_placed++;
-			if (unemployment_dist(m_rng) == 1 && person.m_school_id == 0) {
+			if (unemployment_dist(rng) == 1 && person.m_school_id == 0) {
 				bool filled_cluster = true;
-				if (commute_dist(m_rng) == 0) {
+				if (commute_dist(rng) == 0) {
 					/// Commuting employee
 					filled_cluster = assignCommutingEmployee(person, distance_map);
 				} else {
 					/// Non-commuting employee
-					filled_cluster = assignCloseEmployee(person, radius, distance_map);
+					filled_cluster = assignCloseEmployee(person, radius, distance_map, rng);
 				}
 
 				if (filled_cluster) {
@@ -1115,7 +1199,7 @@ void PopulationGenerator<U>::assignToWork() {
 
 template<class U>
 bool PopulationGenerator<U>::assignCommutingEmployee(SimplePerson& person,
-													 vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map) {
+													 DistanceMap& distance_map) {
 	/// TODO ask question: it states that a full workplace has to be ignored
 	/// but workplaces can be in cities and villages where commuting is only in cities  => possible problems with over-employing in cities
 	/// Behavior on that topic is currently as follows: do the thing that is requested, if all cities are full, it just adds to the first village in the list
@@ -1139,7 +1223,7 @@ bool PopulationGenerator<U>::assignCommutingEmployee(SimplePerson& person,
 
 template<class U>
 bool PopulationGenerator<U>::assignCloseEmployee(SimplePerson& person, double start_radius,
-												 vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map) {
+												 DistanceMap& distance_map, U& rng) {
 	double factor = m_props.get<double>("population.commutingdata.<xmlattr>.factor");
 	double current_radius = start_radius;
 
@@ -1152,7 +1236,7 @@ bool PopulationGenerator<U>::assignCloseEmployee(SimplePerson& person, double st
 
 	AliasDistribution dist {
 			vector<double>(closest_clusters_indices.size(), 1.0 / double(closest_clusters_indices.size()))};
-	uint rnd = dist(m_rng);
+	uint rnd = dist(rng);
 	auto index = closest_clusters_indices.at(rnd);
 	SimpleCluster& workplace = m_workplaces.at(index);
 
@@ -1169,9 +1253,10 @@ bool PopulationGenerator<U>::assignCloseEmployee(SimplePerson& person, double st
 }
 
 template<class U>
-void PopulationGenerator<U>::assignToCommunities(vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map,
+void PopulationGenerator<U>::assignToCommunities(DistanceMap& distance_map,
 												 vector<SimpleCluster>& clusters,
 												 uint SimplePerson::* member,
+												 U& rng,
 												 const string& name) {
 
 	double start_radius = m_props.get<double>("population.commutingdata.<xmlattr>.start_radius");
@@ -1198,7 +1283,7 @@ void PopulationGenerator<U>::assignToCommunities(vector<pair<GeoCoordinate, map<
 
 		AliasDistribution dist {
 				vector<double>(closest_clusters_indices.size(), 1.0 / double(closest_clusters_indices.size()))};
-		uint index = closest_clusters_indices.at(dist(m_rng));
+		uint index = closest_clusters_indices.at(dist(rng));
 		SimpleCluster& community = clusters.at(index);
 		for (uint& person_index: household.m_indices) {
 			SimplePerson& person = m_people.at(person_index);
@@ -15,6 +15,8 @@
 
 #include "util/AliasDistribution.h"
 #include "util/GeoCoordCalculator.h"
+#include "util/unipar.h"
+#include "popgen/DistanceMap.h"
 #include "popgen/utils.h"
 #include "core/ClusterType.h"
 
@@ -33,24 +35,52 @@ template<class U>
 class PopulationGenerator {
 public:
 	/// Constructor: Check if the xml is valid and set up the basic things like a random generator
-	PopulationGenerator(const string& filename, const int& seed, bool output = true);
+	/// With num_threads = 0 the population is generated sequentially with a single random generator, otherwise
+	/// the households are placed and the people assigned in parallel, with a random stream for every partition
+	/// of the work (the population then depends on the seed, not on the number of threads)
+	PopulationGenerator(const string& filename, const int& seed, bool output = true, uint num_threads = 0);
 
 	/// Generates a population, writes the result to the files found in the data directory
 	/// Output files are respectively formatted according to the following template files: belgium_population.csv, pop_miami.csv, pop_miami_geo.csv
-	void generate(const string& prefix);
+	/// With compress the csv files are written with gzip (and get the extension .csv.gz), with binary the people
+	/// are written as a binary population file (see PopulationFile) instead of a csv file
+	void generate(const string& prefix, bool compress = false, bool binary = false);
 
 private:
+	/// The random streams of the parallel mode, one per stage
+	enum Stream : uint {
+		PlaceHouseholds = 1, Schools, UniversitiesWork, PrimaryCommunities, SecondaryCommunities
+	};
+
+	/// The random generator of one partition of a stage in the parallel mode (only depends on the seed,
+	/// the stage and the partition)
+	U makeRng(Stream stream, uint partition) const {
+		seed_seq seq {uint(m_seed), uint(stream), partition};
+		U rng(seq);
+		return rng;
+	}
+
+	/// Assign people to schools, universities, workplaces and communities: the schools in partitions
+	/// of the population, then the universities and work, and both kinds of communities, side by side
+	void assignInParallel();
+
+	/// Number of people of an age between min_age and max_age (both included)
+	uint countAges(uint min_age, uint max_age) const;
+
 	/// Writes the cities to the file, see PopulationGenerator::generate, recently, the villages have been added to this
-	void writeCities(const string& target_cities);
+	void writeCities(const string& target_cities, bool compress);
 
 	/// Writes the population to the file, see PopulationGenerator::generate
-	void writePop(const string& target_pop) const;
+	void writePop(const string& target_pop, bool compress) const;
+
+	/// Writes the population to the file as a binary population file, column by column
+	void writePopBinary(const string& target_pop) const;
 
 	/// Writes the households to the file, see PopulationGenerator::generate
-	void writeHouseholds(const string& target_households) const;
+	void writeHouseholds(const string& target_households, bool compress) const;
 
 	/// Writes the clusters to the file (type, ID and coordinates), see PopulationGenerator::generate
-	void writeClusters(const string& target_clusters) const;
+	void writeClusters(const string& target_clusters, bool compress) const;
 
 	/// Checks the xml on correctness, this includes only semantic errors, no syntax errors
 	void checkForValidXML() const;
@@ -77,173 +107,46 @@ private:
 	void makeVillages();
 
 
-	/// Precompute the distances between the locations of the clusters (given as an argument) and the districts (villages and cities)
-	/// The distances measured will start at the radius given as an argument
-	/// If not all clusters are within that radius, the radius will be mulktiplied with the given factor until all clusters have their distance computed
-	/// The result is a vector of pairs, where each pair maps a coordinate of a city to another map
-	/// This inner map has a radius as a key and a vector of indices as its value, these indices refer to the clusters passed as an argument
-	/// assume ret_val is the return value:
-	/// ret_val.at(x).second[10.0] = the indices of all clusters within a radius of 10.0 kilometres of a certain city
-	/// ret_val.at(x).first = the coordinate of the "certain city" used above
+	/// Index the locations of the clusters (given as an argument) for PopulationGenerator::getClustersWithinRange.
+	/// The distances to the clusters are measured in rings: the radius given as an argument, multiplied with
+	/// the given factor for every next ring (see DistanceMap).
 	template<typename T>
-	vector<pair<GeoCoordinate, map<double, vector<uint>>>>
-	makeDistanceMap(double radius, double factor, const vector<T>& clusters) const {
-		vector<pair<GeoCoordinate, map<double, vector<uint>>>> distance_map;
-
-		const GeoCoordCalculator& calc = GeoCoordCalculator::getInstance();
-
-		if (m_output) cerr << "Building distance map for the next cluster type [0%]";
-
-		uint done = 0;
-		uint total = m_cities.size() + m_villages.size();
-
-		for (auto& city: m_cities) {
-			if (m_output) cerr << "\rBuilding distance map for the next cluster type [" << done / total << "%]";
-			++done;
-
-			double current_radius = radius;
-			uint used_clusters = 0;
-			vector<bool> clusters_used = vector<bool>(clusters.size(), false);
-
-			distance_map.push_back(make_pair(city.m_coord, map<double, vector<uint>>()));
-
-			while (used_clusters != clusters.size()) {
-
-				for (uint i = 0; i < clusters.size(); ++i) {
-					if ((!clusters_used.at(i)) &&
-						calc.getDistance(city.m_coord, clusters.at(i).m_coord) <= current_radius) {
-						distance_map.back().second[current_radius].push_back(i);
-						clusters_used.at(i) = true;
-						++used_clusters;
-					}
-				}
-
-				current_radius *= factor;
-
-			}
-
-		}
-
-
-		for (auto& village: m_villages) {
-			if (m_output) cerr << "\rBuilding distance map for the next cluster type [" << done / total << "%]";
-			++done;
-
-			double current_radius = radius;
-			uint used_clusters = 0;
-			vector<bool> clusters_used = vector<bool>(clusters.size(), false);
-
-			distance_map.push_back(make_pair(village.m_coord, map<double, vector<uint>>()));
-
-			while (used_clusters != clusters.size()) {
-
-				for (uint i = 0; i < clusters.size(); ++i) {
-					if (!clusters_used.at(i) &&
-						calc.getDistance(village.m_coord, clusters.at(i).m_coord) <= current_radius) {
-						distance_map.back().second[current_radius].push_back(i);
-						clusters_used.at(i) = true;
-						++used_clusters;
-					}
-				}
-
-				current_radius *= factor;
-
-			}
-
+	DistanceMap makeDistanceMap(double radius, double factor, const vector<T>& clusters) const {
+		vector<GeoCoordinate> locations;
+		locations.reserve(clusters.size());
+		for (const auto& cluster: clusters) {
+			locations.push_back(cluster.m_coord);
 		}
-
-		if (m_output) cerr << "\rBuilding distance map for the next cluster type [100%]...\n";
-
-		return distance_map;
+		if (m_output) cerr << "Building distance map for the next cluster type [100%]...\n";
+		return DistanceMap(locations, radius, factor);
 	}
 
 	/// Specialization of makeDistanceMap, except now the clusters aren't a vector of clusters anymore, instead, they are a vector of vectors
 	/// This is because the schools are a cluster of clusters (and thus a vector of vectors)
 	template<typename T>
-	vector<pair<GeoCoordinate, map<double, vector<uint>>>>
-	makeDistanceMap(double radius, double factor, const vector<vector<T>>& clusters) const {
-		vector<pair<GeoCoordinate, map<double, vector<uint>>>> distance_map;
-
-		const GeoCoordCalculator& calc = GeoCoordCalculator::getInstance();
-
-		for (auto& city: m_cities) {
-
-			double current_radius = radius;
-			uint used_clusters = 0;
-			vector<bool> clusters_used = vector<bool>(clusters.size(), false);
-
-			distance_map.push_back(make_pair(city.m_coord, map<double, vector<uint>>()));
-
-			while (used_clusters != clusters.size()) {
-
-				for (uint i = 0; i < clusters.size(); ++i) {
-					if ((!clusters_used.at(i)) &&
-						calc.getDistance(city.m_coord, clusters.at(i).front().m_coord) <= current_radius) {
-						distance_map.back().second[current_radius].push_back(i);
-						clusters_used.at(i) = true;
-						++used_clusters;
-					}
-				}
-
-				current_radius *= factor;
-
-			}
-
+	DistanceMap makeDistanceMap(double radius, double factor, const vector<vector<T>>& clusters) const {
+		vector<GeoCoordinate> locations;
+		locations.reserve(clusters.size());
+		for (const auto& cluster: clusters) {
+			locations.push_back(cluster.front().m_coord);
 		}
-
-		for (auto& village: m_villages) {
-
-			double current_radius = radius;
-			uint used_clusters = 0;
-			vector<bool> clusters_used = vector<bool>(clusters.size(), false);
-
-			distance_map.push_back(make_pair(village.m_coord, map<double, vector<uint>>()));
-
-			while (used_clusters != clusters.size()) {
-
-				for (uint i = 0; i < clusters.size(); ++i) {
-					if (!clusters_used.at(i) &&
-						calc.getDistance(village.m_coord, clusters.at(i).front().m_coord) <= current_radius) {
-						distance_map.back().second[current_radius].push_back(i);
-						clusters_used.at(i) = true;
-						++used_clusters;
-					}
-				}
-
-				current_radius *= factor;
-
-			}
-
-		}
-
-		return distance_map;
+		return DistanceMap(locations, radius, factor);
 	}
 
 	/// Get the clusters that are within the range of a certain coordinate and radius (both given as an argument)
-	/// The distances are precomputed by PopulationGenerator::makeDistanceMap and the result of that function has to be passed as an argument to this function
+	/// The distance map is made by PopulationGenerator::makeDistanceMap and has to be passed as an argument to this function
 	vector<uint>
-	getClustersWithinRange(double radius, const vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map,
-						   GeoCoordinate coordinate) const {
-		for (auto& coord_map_pair: distance_map) {
-			if (coord_map_pair.first == coordinate) {
-				vector<uint> result;
-
-				for (auto it = coord_map_pair.second.begin(); it != coord_map_pair.second.end(); ++it) {
-					if (it->first <= radius) {
-						result.insert(result.end(), it->second.begin(), it->second.end());
-					}
-				}
-
-				return result;
-			}
-		}
-
-		return vector<uint>();
+	getClustersWithinRange(double radius, const DistanceMap& distance_map, GeoCoordinate coordinate) const {
+		return distance_map.getClustersWithinRange(radius, coordinate);
 	}
 
 	/// Assign the households to a city/village
 	void placeHouseholds();
 
+	/// Choose a school and a class in it for a child, returns their indices
+	pair<uint, uint> chooseSchool(const SimplePerson& person, const DistanceMap& distance_map,
+								  double start_radius, double factor, U& rng) const;
+
 	/// Spreads the clusters of people with these constraints over the cities and villages
 	/// size: the size of each cluster
 	/// min_age and max_age: the category of people that belongs to these clusters (e.g. schools an work have a minimum/maximum age)
@@ -345,42 +248,45 @@ private:
 	void assignToSchools();
 
 	/// Put students in universities
-	void assignToUniversities();
+	void assignToUniversities(U& rng);
 
 	/// Remove an element from the university map (the university map is special compared to other cluster maps, this is because a university is a cluster of clusters)
-	void removeFromUniMap(vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map, uint index) const;
+	void removeFromUniMap(DistanceMap& distance_map, uint index) const;
 
 	/// Remove an element from the map (of regular clusters, not like universities, because they represent a cluster of clusters)
 	/// Return true if the element is deleted, false if not
-	bool removeFromMap(vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map, uint index) const;
+	bool removeFromMap(DistanceMap& distance_map, uint index) const;
 
 	/// Put one student in a university according to the rules of commuting students
 	void
-	assignCommutingStudent(SimplePerson& person, vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map);
+	assignCommutingStudent(SimplePerson& person, DistanceMap& distance_map);
 
 	/// Put one student in a university according to the rules of students that study close to their home
 	void assignCloseStudent(SimplePerson& person, double start_radius,
-							vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map);
+							DistanceMap& distance_map, U& rng);
 
 	/// Assign people to a workplace
-	void assignToWork();
+	void assignToWork(U& rng);
 
 	/// Assign one person to a workplace according to the rule of commuting workers
 	bool
-	assignCommutingEmployee(SimplePerson& person, vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map);
+	assignCommutingEmployee(SimplePerson& person, DistanceMap& distance_map);
 
 	/// Assign one person to a workplace according to the rule of workers that work close to their home
 	bool assignCloseEmployee(SimplePerson& person, double start_radius,
-							 vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map);
+							 DistanceMap& distance_map, U& rng);
 
 	/// Assign entire households
-	void assignToCommunities(vector<pair<GeoCoordinate, map<double, vector<uint>>>>& distance_map,
+	void assignToCommunities(DistanceMap& distance_map,
 							 vector<SimpleCluster>& clusters,
 							 uint SimplePerson::* member,
+							 U& rng,
 							 const string& name = "");
 
 	boost::property_tree::ptree m_props;                            /// > The content of the xml file
 	U m_rng;                                        /// > The random generator
+	int m_seed;                                                        /// > The seed of the random generator(s)
+	uint m_num_threads;                                                /// > The number of threads, 0 for the sequential mode
 	uint m_total;                                                    /// > The total amount of people to be generated (according to the xml)
 	vector<SimplePerson> m_people;                                    /// > All the people
 	vector<SimpleHousehold> m_households;                            /// > The households (a household is a vector of indices in the vector above)
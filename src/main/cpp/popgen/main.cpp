@@ -12,9 +12,9 @@ using namespace popgen;
 using namespace TCLAP;
 
 template<class T>
-void run(T generator, const string& prefix) {
+void run(T generator, const string& prefix, bool compress, bool binary) {
 	cerr << "Generating...\n";
-	generator.generate(prefix);
+	generator.generate(prefix, compress, binary);
 	cerr << "Done!\n";
 }
 
@@ -34,6 +34,15 @@ int main(int argc, char** argv) {
 		ValueArg<int> seedArg("s", "seed", "The seed of the random generator", false, 1, "int");
 		cmd.add(seedArg);
 
+		ValueArg<unsigned int> threadsArg("t", "threads",
+										  "Generate in parallel with this number of threads (0: sequentially)."
+										  " The parallel mode uses a random stream per partition of the work, its"
+										  " populations differ from the sequential ones, but not between numbers of threads",
+										  false, 0, "unsigned int", cmd);
+
+		SwitchArg gzipArg("z", "gzip", "Write the csv files compressed with gzip (extension .csv.gz)", cmd, false);
+		SwitchArg binaryArg("b", "binary", "Write the people as a binary population file (extension .bin)", cmd, false);
+
 		// Parse the argv array
 		cmd.parse(argc, argv);
 
@@ -42,38 +51,41 @@ int main(int argc, char** argv) {
 		string prefix = outputPrefixArg.getValue();
 		string rng = rngArg.getValue();
 		int seed = seedArg.getValue();
+		unsigned int threads = threadsArg.getValue();
+		bool compress = gzipArg.getValue();
+		bool binary = binaryArg.getValue();
 
 		cerr << "Starting...\n";
 		if (rng == "default_random_engine") {
-			PopulationGenerator<default_random_engine> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<default_random_engine> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "mt19937") {
-			PopulationGenerator<mt19937> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<mt19937> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "mt19937_64") {
-			PopulationGenerator<mt19937_64> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<mt19937_64> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "minstd_rand0") {
-			PopulationGenerator<minstd_rand0> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<minstd_rand0> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "minstd_rand") {
-			PopulationGenerator<minstd_rand> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<minstd_rand> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "ranlux24_base") {
-			PopulationGenerator<ranlux24_base> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<ranlux24_base> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "ranlux48_base") {
-			PopulationGenerator<ranlux48_base> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<ranlux48_base> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "ranlux24") {
-			PopulationGenerator<ranlux24> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<ranlux24> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "ranlux48") {
-			PopulationGenerator<ranlux48> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<ranlux48> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		} else if (rng == "knuth_b") {
-			PopulationGenerator<knuth_b> generator {sourceXml, seed};
-			run(generator, prefix);
+			PopulationGenerator<knuth_b> generator {sourceXml, seed, true, threads};
+			run(generator, prefix, compress, binary);
 		}
 	} catch (ArgException& exc) {
 		cerr << "Error: " << exc.error() << " for argument " << exc.argId() << endl;
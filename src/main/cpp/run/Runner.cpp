@@ -116,6 +116,16 @@ void Runner::initSimulators() {
 		}
 	}
 
+	// All local simulators save their checkpoints in one file, written by one thread.
+	auto checkpointing = m_config.get_child_optional("run.outputs.checkpointing");
+	if (checkpointing && checkpointing.get().get<bool>("<xmlattr>.single_file", false)) {
+		if (m_uses_mpi) {
+			throw runtime_error("A single checkpoint file can't be shared by the processes of an MPI run");
+		}
+		// Replay and extend load from the file first, so only a new run starts a new file.
+		m_hdf5_writer = make_shared<Hdf5Writer>(hdf5Path("").string(), m_mode != RunMode::Initial);
+	}
+
 	for (auto& it: m_region_configs) {
 		cout << "\r--> Initializing simulators [" << i << "/" << m_region_configs.size() << "]";
 		i++;
@@ -171,8 +181,12 @@ shared_ptr<Simulator> Runner::addLocalSimulator(const string& name, const boost:
 
 	if (m_mode == RunMode::Replay || m_mode == RunMode::Extend) {
 		// adjust the state of the simulator
-		std::string pathStr = hdf5Path(name).string();
-		Hdf5Loader loader = Hdf5Loader(pathStr.c_str());
+		std::string pathStr = hdf5Path(m_hdf5_writer ? "" : name).string();
+		if (m_hdf5_writer) {
+			// The initial checkpoints of the other regions may still be in the queue.
+			m_hdf5_writer->flush();
+		}
+		Hdf5Loader loader = Hdf5Loader(pathStr.c_str(), m_hdf5_writer ? name : "");
 
 		int timestep = m_mode == RunMode::Extend ?
 					   loader.getLastSavedTimestep() : m_timestep;
@@ -294,8 +308,13 @@ void Runner::initOutputs(Simulator& sim) {
 	auto checkpointing = m_config.get_child_optional("run.outputs.checkpointing");
 	if (checkpointing) {
 		int freq = checkpointing.get().get<int>("<xmlattr>.frequency");
-		auto saver = make_shared<Hdf5Saver>(hdf5Path(sim.getName()).string().c_str(), sim.m_config_pt,
-											freq, m_mode, m_timestep);
+		bool background = checkpointing.get().get<bool>("<xmlattr>.background", false);
+		unsigned int keyframe_interval = checkpointing.get().get<unsigned int>("<xmlattr>.keyframe_interval", 0U);
+		auto saver = m_hdf5_writer ?
+					 make_shared<Hdf5Saver>(m_hdf5_writer, sim.getName(), sim.m_config_pt, freq, m_mode, m_timestep,
+											keyframe_interval) :
+					 make_shared<Hdf5Saver>(hdf5Path(sim.getName()).string().c_str(), sim.m_config_pt,
+											freq, m_mode, m_timestep, background, keyframe_interval);
 		auto fn = std::bind(&Hdf5Saver::update, saver, std::placeholders::_1);
 		sim.registerObserver(saver, fn);
 		m_hdf5_savers[sim.getName()] = saver;
@@ -381,6 +400,11 @@ void Runner::run() {
 	}
 #endif
 
+	// Checkpoints that are still being written in the background.
+	for (auto& it: m_hdf5_savers) {
+		it.second->flush();
+	}
+
 	// More output!
 	// TODO only save at last timestep if freq == 0
 	// for (auto& it: m_hdf5_savers) {
@@ -419,5 +443,5 @@ pt::ptree Runner::getRegionsConfig(const std::vector<string>& names) {
 }
 
 fs::path Runner::hdf5Path(const string& name) {
-	return fs::system_complete(m_output_dir / (string("cp_") + name + ".h5"));
+	return fs::system_complete(m_output_dir / (name.empty() ? string("cp.h5") : string("cp_") + name + ".h5"));
 }
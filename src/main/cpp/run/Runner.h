@@ -68,6 +68,7 @@ private:
 
 	void makeSetupStruct();
 
+	/// Checkpoint file of the simulator with the given name, or the shared one (see Hdf5Writer) for "".
 	boost::filesystem::path hdf5Path(const string& name);
 
 	std::map<std::string, std::string> m_overrides;
@@ -102,6 +103,7 @@ private:
 	boost::filesystem::path m_output_dir;
 	std::string m_travel_schedule;
 
+	std::shared_ptr<Hdf5Writer> m_hdf5_writer;   ///< Writes the checkpoints of all simulators, if in a single file.
 	std::map<std::string, std::shared_ptr<Hdf5Saver>> m_hdf5_savers;
 	std::map<std::string, std::shared_ptr<ClusterSaver>> m_vis_savers;
 };
@@ -0,0 +1,52 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2015, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Converter of people files (csv) to binary population files.
+ */
+
+#include "pop/PopulationFile.h"
+
+#include <tclap/CmdLine.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace stride;
+using namespace TCLAP;
+
+int main(int argc, char** argv) {
+	int exit_status = EXIT_SUCCESS;
+	try {
+		// Parse command line.
+		CmdLine cmd("pop_converter", ' ', "1.0", false);
+		ValueArg<string> input_Arg("i", "input", "People file (csv)", true, "", "filename", cmd);
+		ValueArg<string> output_Arg("o", "output", "Binary population file", true, "", "filename", cmd);
+		cmd.parse(argc, argv);
+
+		PopulationFile::convert(input_Arg.getValue(), output_Arg.getValue());
+		cout << "Converted " << input_Arg.getValue() << " to " << output_Arg.getValue() << " ("
+			 << PopulationFile(output_Arg.getValue()).size() << " people)." << endl;
+	} catch (ArgException& e) {
+		exit_status = EXIT_FAILURE;
+		cerr << "Error: " << e.error() << " for argument " << e.argId() << endl;
+	} catch (exception& e) {
+		exit_status = EXIT_FAILURE;
+		cerr << endl << "Exception: " << e.what() << endl;
+	}
+	return exit_status;
+}
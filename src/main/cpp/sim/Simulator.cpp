@@ -30,9 +30,9 @@
 #include "util/GeoCoordCalculator.h"
 #include "util/etc.h"
 
-#include <random>
 #include <algorithm>
 #include <mutex>
+#include <type_traits>
 
 namespace stride {
 
@@ -40,17 +40,31 @@ using namespace std;
 using namespace boost::property_tree;
 using namespace stride::util;
 
+namespace {
+
+/// Number of consecutive clusters (by index) that share a random stream.
+const size_t g_cluster_block_size = 256U;
+
+/// Minimal estimated cost of a task of clusters with balanced scheduling.
+const size_t g_min_task_cost = 1024U;
+
+/// Offset of a random stream in the sequence of the day: every stream gets a disjoint part of 2^36 numbers.
+unsigned long long streamOffset(unsigned long long stream) {
+	return stream << 36U;
+}
+
+/// Stream of a block of clusters of one type (up to 2^20 blocks per cluster type).
+unsigned long long streamOffset(ClusterType cluster_type, size_t block) {
+	return streamOffset((static_cast<unsigned long long>(toSizeType(cluster_type)) << 20U) + block);
+}
+
+}
+
 Simulator::Simulator()
-		: m_num_threads(1U), m_log_level(LogMode::Null), m_config_pt(), m_population(nullptr),
+		: m_num_threads(1U), m_log_level(LogMode::Null), m_contact_sampling(ContactSampling::Pairwise),
+		  m_cluster_scheduling(ClusterScheduling::PerType), m_hot_clusters_only(true),
+		  m_config_pt(), m_population(nullptr),
 		  m_disease_profile(), m_track_index_case(false), m_next_id(0), m_next_hh_id(0) {
-	m_parallel.resources().setFunc([&]() {
-		#if UNIPAR_IMPL == UNIPAR_DUMMY
-		return m_rng.get();
-		#else
-		std::random_device rd;
-		return make_unique<Random>(rd());
-		#endif
-	});
 }
 
 const shared_ptr<const Population> Simulator::getPopulation() const {
@@ -63,17 +77,170 @@ void Simulator::setTrackIndexCase(bool track_index_case) {
 
 template<LogMode log_level, bool track_index_case>
 void Simulator::updateClusters() {
+	// Without local information or contact logging, nothing happens in a cluster
+	// without infectious members, so only the "hot" clusters need to be visited.
+	const bool hot_only = m_hot_clusters_only && is_same<LocalInformationPolicy, NoLocalInformation>::value
+						  && log_level != LogMode::Contacts;
+	if (hot_only) {
+		updateHotClusters();
+	}
+
+	// Every block of clusters draws from its own stream, split off from a sequence seeded by m_rng
+	// once per day. This makes the results independent of the number of threads (and the order in
+	// which the blocks are done), and the state of m_rng is all a checkpoint needs. The blocks are
+	// ranges of cluster indices, and a cluster without infectious members draws nothing, so visiting
+	// only the hot clusters of a block gives the same result as visiting all of them.
+	const unsigned long day_seed = (*m_rng)();
+
+	// Clusters of different types share members, which only the information policy
+	// without exchange between them can handle in one go.
+	if (m_cluster_scheduling == ClusterScheduling::Balanced
+		&& is_same<LocalInformationPolicy, NoLocalInformation>::value) {
+		updateClustersBalanced<log_level, track_index_case>(hot_only, day_seed);
+		return;
+	}
+
 	// Slight hack (thanks to http://stackoverflow.com/q/31724863/2678118#comment51385875_31724863)
 	// but saves us a lot of typing without resorting to macro's.
 	for (auto clusters: {&m_households, &m_school_clusters, &m_work_clusters,
 						 &m_primary_community, &m_secondary_community}) {
-		m_parallel.for_(0, clusters->size(), [&](RandomRef& rng, size_t i) {
-			Infector<log_level, track_index_case, LocalInformationPolicy>::execute(
-					(*clusters)[i], m_disease_profile, *rng, m_calendar, *m_logger);
+		if (clusters->empty()) {
+			continue;
+		}
+		const auto cluster_type = clusters->front().getClusterType();
+		const auto& hot = m_hot_clusters[toSizeType(cluster_type)];
+
+		// Start of the blocks in the list of clusters to visit (the hot ones, or all of them).
+		vector<size_t> block_begin;
+		if (hot_only) {
+			for (size_t i = 0; i < hot.size(); i++) {
+				if (i == 0 || hot[i] / g_cluster_block_size != hot[i - 1] / g_cluster_block_size) {
+					block_begin.push_back(i);
+				}
+			}
+			block_begin.push_back(hot.size());
+		} else {
+			for (size_t i = 0; i < clusters->size(); i += g_cluster_block_size) {
+				block_begin.push_back(i);
+			}
+			block_begin.push_back(clusters->size());
+		}
+
+		m_parallel.for_(0, block_begin.size() - 1, [&](size_t block) {
+			const size_t first = block_begin[block];
+			Random rng(day_seed);
+			rng.jump(streamOffset(cluster_type, (hot_only ? hot[first] : first) / g_cluster_block_size));
+			for (size_t i = first; i < block_begin[block + 1]; i++) {
+				Infector<log_level, track_index_case, LocalInformationPolicy>::execute(
+						(*clusters)[hot_only ? hot[i] : i], m_disease_profile, rng, m_calendar, *m_logger,
+						m_contact_sampling);
+			}
 		});
 	}
 }
 
+template<LogMode log_level, bool track_index_case>
+void Simulator::updateClustersBalanced(bool hot_only, unsigned long day_seed) {
+	using ClusterInfector = Infector<log_level, track_index_case, NoLocalInformation>;
+
+	// The cost of a cluster is about its size times the number of infectious members
+	// (or times its size, when every contact is needed).
+	vector<pair<size_t, Cluster*>> jobs;
+	for (auto clusters: {&m_households, &m_school_clusters, &m_work_clusters,
+						 &m_primary_community, &m_secondary_community}) {
+		if (clusters->empty()) {
+			continue;
+		}
+		const auto type = toSizeType(clusters->front().getClusterType());
+		if (hot_only) {
+			for (size_t i = 0; i < m_hot_clusters[type].size(); i++) {
+				auto& cluster = (*clusters)[m_hot_clusters[type][i]];
+				jobs.emplace_back(cluster.getSize() * m_hot_cluster_cases[type][i], &cluster);
+			}
+		} else {
+			for (auto& cluster: *clusters) {
+				jobs.emplace_back(cluster.getSize() * cluster.getSize(), &cluster);
+			}
+		}
+	}
+
+	// The expensive clusters go first, so they are not left for the end. The cheap ones are
+	// binned into tasks of a minimal cost. Both are independent of the number of threads
+	// (the stable sort keeps the equal ones in order), and so are the streams of the tasks.
+	stable_sort(jobs.begin(), jobs.end(), [](const pair<size_t, Cluster*>& a, const pair<size_t, Cluster*>& b) {
+		return a.first > b.first;
+	});
+	vector<size_t> task_begin;
+	size_t task_cost = g_min_task_cost;
+	for (size_t j = 0; j < jobs.size(); j++) {
+		if (task_cost >= g_min_task_cost) {
+			task_begin.push_back(j);
+			task_cost = 0U;
+		}
+		task_cost += jobs[j].first;
+	}
+	task_begin.push_back(jobs.size());
+	const size_t num_tasks = task_begin.size() - 1;
+
+	// A person can be infected in several clusters at the same time, so the
+	// infections wait until all clusters are done, and then go in order of the tasks.
+	vector<vector<Transmission>> transmissions(num_tasks);
+	m_parallel.dynamicFor_(0U, num_tasks, [&](size_t task) {
+		Random rng(day_seed);
+		rng.jump(streamOffset(task));
+		for (size_t j = task_begin[task]; j < task_begin[task + 1]; j++) {
+			ClusterInfector::execute(*jobs[j].second, m_disease_profile, rng, m_calendar, *m_logger,
+									 m_contact_sampling, &transmissions[task]);
+		}
+	});
+	for (const auto& task_transmissions: transmissions) {
+		for (const auto& transmission: task_transmissions) {
+			ClusterInfector::transmit(*m_population, transmission, m_calendar, *m_logger);
+		}
+	}
+}
+
+void Simulator::updateHotClusters() {
+	for (auto& hot: m_hot_clusters) {
+		hot.clear();
+	}
+
+	// The cluster ids of a person are the indices in the cluster vectors. Visitors get a household
+	// id past the last household (see SimulatorBuilder), which is skipped.
+	for (const auto index: m_population->getInfectious()) {
+		const auto& person = m_population->getPerson(index);
+		for (auto type: {ClusterType::Household, ClusterType::School, ClusterType::Work,
+						 ClusterType::PrimaryCommunity, ClusterType::SecondaryCommunity}) {
+			const size_t id = person.getClusterId(type);
+			if (id < getClusters(type).size()) {
+				m_hot_clusters[toSizeType(type)].push_back(id);
+			}
+		}
+	}
+
+	// Visit the clusters in their original order, once (but keep the number of infectious members).
+	for (size_t type = 0; type < numOfClusterTypes(); type++) {
+		auto& hot = m_hot_clusters[type];
+		auto& cases = m_hot_cluster_cases[type];
+		sort(hot.begin(), hot.end());
+		cases.clear();
+		for (size_t i = 0; i < hot.size(); i++) {
+			if (!cases.empty() && hot[i] == hot[cases.size() - 1]) {
+				cases.back()++;
+			} else {
+				hot[cases.size()] = hot[i];
+				cases.push_back(1U);
+			}
+		}
+		hot.resize(cases.size());
+	}
+}
+
+void Simulator::updateContactProbabilities(Cluster& cluster) {
+	cluster.setContactProbabilities(m_contact_probabilities[toSizeType(cluster.getClusterType())],
+									m_disease_profile.getTransmissionRate());
+}
+
 SimulatorStatus Simulator::timeStep() {
 	// Advance the "calendar" of the districts (for the sphere of influence)
 	for (auto& district: m_districts) {
@@ -92,9 +259,7 @@ SimulatorStatus Simulator::timeStep() {
 
 	double fraction_infected = m_population->getFractionInfected();
 
-	for (auto& p : *m_population) {
-		p.update(is_work_off, is_school_off, fraction_infected);
-	}
+	m_population->update(is_work_off, is_school_off, fraction_infected, m_parallel);
 
 	if (m_track_index_case) {
 		switch (m_log_level) {
@@ -128,8 +293,8 @@ SimulatorStatus Simulator::timeStep() {
 
 	m_calendar->advanceDay();
 	this->notify(*this);
-	return SimulatorStatus(m_population->getInfectedCount(),
-						   m_population->getAdoptedCount<Simulator::BeliefPolicy>());
+	const auto stats = m_population->getStats();
+	return SimulatorStatus(stats.getInfectedCount(), stats.getAdoptedCount());
 }
 
 const vector<Cluster>& Simulator::getClusters(ClusterType cluster_type) const {
@@ -161,24 +326,20 @@ void Simulator::setRngStates(vector<string> states) {
 	m_rng->setState(states.at(0));
 }
 
-uint Simulator::chooseCluster(const GeoCoordinate& coordinate, const vector<Cluster>& clusters, double influence) {
+uint Simulator::chooseCluster(const GeoCoordinate& coordinate, ClusterType cluster_type, double influence) {
 	double current_influence = influence;
+	const auto& grid = m_cluster_grids[toSizeType(cluster_type)];
 
-	if (clusters.size() == 0) {
+	// Cluster 0 is no cluster.
+	if (grid.size() <= 1) {
 		throw runtime_error(string(__func__) + string("> Empty cluster vector."));
 	}
 
+	vector<uint> available_clusters;
 	while (true) {
-		vector<uint> available_clusters;
-		const auto& calc = GeoCoordCalculator::getInstance();
-
-		for (uint i = 1; i < clusters.size(); ++i) {
-
-			const auto& cluster = clusters.at(i);
-
-			if (calc.getDistance(coordinate, cluster.getLocation()) <= current_influence) {
-				available_clusters.push_back(i);
-			}
+		grid.findWithin(coordinate, current_influence, available_clusters);
+		if (!available_clusters.empty() && available_clusters.front() == 0) {
+			available_clusters.erase(available_clusters.begin());
 		}
 
 		if (available_clusters.size() != 0) {
@@ -215,14 +376,13 @@ bool Simulator::hostForeignTravellers(const vector<Simulator::TravellerType>& tr
 	}
 
 	// So that the addresses don't break, reserve the space needed in the vector
-	this->m_population.get()->m_visitors.getDay(days);
-	this->m_population.get()->m_visitors.getModifiableDay(days)->reserve(travellers.size());
+	this->m_population->m_visitors.getModifiableDay(days)->reserve(travellers.size());
 
 	for (const Simulator::TravellerType& traveller: travellers) {
 		// Choose the clusters the traveller will reside in
-		uint work_index = this->chooseCluster(facility_location, this->m_work_clusters, influence);
-		uint prim_comm_index = this->chooseCluster(facility_location, this->m_primary_community, influence);
-		uint sec_comm_index = this->chooseCluster(facility_location, this->m_secondary_community, influence);
+		uint work_index = this->chooseCluster(facility_location, ClusterType::Work, influence);
+		uint prim_comm_index = this->chooseCluster(facility_location, ClusterType::PrimaryCommunity, influence);
+		uint sec_comm_index = this->chooseCluster(facility_location, ClusterType::SecondaryCommunity, influence);
 
 		if (work_index == this->m_work_clusters.size()
 			|| prim_comm_index == this->m_primary_community.size()
@@ -247,12 +407,11 @@ bool Simulator::hostForeignTravellers(const vector<Simulator::TravellerType>& tr
 		new_person.getHealth() = traveller.getHomePerson().getHealth();
 
 		// Add the person to the planner
-		this->m_population->m_visitors.add(days, new_person);
+		const PersonIndex person_index = this->m_population->addVisitor(days, new_person);
 
 		// Note: the ID of a non-traveller is always the same as his index in m_population->m_original
 		Simulator::TravellerType new_traveller = Simulator::TravellerType(traveller.getHomePerson(),
-																		  this->m_population->m_visitors.getModifiableDay(
-																				  days)->back().get(),
+																		  &this->m_population->getPerson(person_index),
 																		  traveller.getHomeSimulatorId(),
 																		  traveller.getDestinationSimulatorId(),
 																		  traveller.getHomePerson().getId());
@@ -260,13 +419,13 @@ bool Simulator::hostForeignTravellers(const vector<Simulator::TravellerType>& tr
 		new_traveller.getNewPerson()->setOnVacation(false);
 		m_planner.add(days, new_traveller);
 
-		// Get a pointer to the person you just made
-		Simulator::PersonType* person = this->m_population->m_visitors.getModifiableDay(days)->back().get();
-
 		// Add the person to the clusters
-		this->m_work_clusters.at(work_index).addPerson(person);
-		this->m_primary_community.at(prim_comm_index).addPerson(person);
-		this->m_secondary_community.at(sec_comm_index).addPerson(person);
+		this->m_work_clusters.at(work_index).addPerson(person_index);
+		this->m_primary_community.at(prim_comm_index).addPerson(person_index);
+		this->m_secondary_community.at(sec_comm_index).addPerson(person_index);
+		updateContactProbabilities(m_work_clusters.at(work_index));
+		updateContactProbabilities(m_primary_community.at(prim_comm_index));
+		updateContactProbabilities(m_secondary_community.at(sec_comm_index));
 
 		++m_next_id;
 		++m_next_hh_id;
@@ -280,6 +439,7 @@ bool Simulator::welcomeHomeTravellers(const vector<uint>& travellers_indices, co
 	for (uint i = 0; i < travellers_indices.size(); ++i) {
 		original_population.at(travellers_indices.at(i)).setOnVacation(false);
 		original_population.at(travellers_indices.at(i)).getHealth() = health_status.at(i);
+		m_population->syncColumns(travellers_indices.at(i));
 	}
 
 	return true;
@@ -303,9 +463,15 @@ void Simulator::returnForeignTravellers() {
 		auto sec_comm_index = returning_person->getClusterId(ClusterType::SecondaryCommunity);
 
 		// Remove him from the clusters
-		m_work_clusters.at(work_index).removePerson(returning_person->getId());
-		m_primary_community.at(prim_comm_index).removePerson(returning_person->getId());
-		m_secondary_community.at(sec_comm_index).removePerson(returning_person->getId());
+		const PersonIndex person_index = m_population->getIndex(returning_person);
+		m_population->syncHealth(person_index);
+		m_work_clusters.at(work_index).removePerson(person_index);
+		m_primary_community.at(prim_comm_index).removePerson(person_index);
+		m_secondary_community.at(sec_comm_index).removePerson(person_index);
+		updateContactProbabilities(m_work_clusters.at(work_index));
+		updateContactProbabilities(m_primary_community.at(prim_comm_index));
+		updateContactProbabilities(m_secondary_community.at(sec_comm_index));
+		m_population->removeVisitor(person_index);
 
 		string destination_sim = traveller.getHomeSimulatorId();
 
@@ -350,9 +516,12 @@ void Simulator::sendNewTravellers(uint amount, uint days, const string& destinat
 		// Randomly generate an index in working_people
 		unsigned int index = m_rng->operator()(working_people.size());
 
-		// Get the person to be sent
+		// Get the person to be sent (the disease counter does not run while away)
 		Simulator::PersonType* person = *(next(working_people.begin(), index));
+		const PersonIndex person_index = population.getIndex(person);
+		population.syncHealth(person_index);
 		person->setOnVacation(true);
+		population.syncColumns(person_index);
 
 		// Make the traveller and make sure he can't be sent twice
 		Simulator::TravellerType new_traveller = Simulator::TravellerType(*person, nullptr, m_name, destination_sim,
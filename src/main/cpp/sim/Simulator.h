@@ -27,12 +27,16 @@
 #include "behaviour/behaviour_policies/NoBehaviour.h"
 
 #include "sim/SimulatorStatus.h"
+#include "core/ClusterScheduling.h"
+#include "core/ContactProbabilities.h"
+#include "core/ContactSampling.h"
 #include "core/DiseaseProfile.h"
 #include "core/LogMode.h"
 #include "core/District.h"
 #include "core/ClusterType.h"
 #include "pop/Person.h"
 #include "pop/Traveller.h"
+#include "util/GeoGrid.h"
 #include "util/Subject.h"
 #include "util/Random.h"
 #include "util/unipar.h"
@@ -40,6 +44,7 @@
 #include "behaviour/belief_policies/NoBelief.h"
 #include <boost/property_tree/ptree.hpp>
 #include <spdlog/spdlog.h>
+#include <array>
 #include <memory>
 #include <string>
 #include <vector>
@@ -104,10 +109,9 @@ public:
 	/// Set the states of the rng's
 	void setRngStates(std::vector<std::string> states);
 
-	/// Return an index to a cluster in the given vector
-	/// Current policy: search for the first cluster with equal coordinates
-	/// Return the size of the vector if you can't find any
-	uint chooseCluster(const GeoCoordinate& coordinate, const vector<Cluster>& clusters, double influence);
+	/// Return the index of a random cluster of the given type within the influence range (km) of the coordinate.
+	/// The range is doubled until there is one. Uses the spatial index of the cluster type.
+	uint chooseCluster(const GeoCoordinate& coordinate, ClusterType cluster_type, double influence);
 
 	/// Receive travellers
 	/// @argument travellers: the travellers this simulator has to host. Contains the data needed to identify a person in the home simulator
@@ -156,19 +160,26 @@ private:
 	template<LogMode log_level, bool track_index_case = false>
 	void updateClusters();
 
+	/// Update the contacts in all clusters at once, in tasks of about the same cost.
+	template<LogMode log_level, bool track_index_case = false>
+	void updateClustersBalanced(bool hot_only, unsigned long day_seed);
+
+	/// Collect the clusters with infectious members (by type, sorted on index).
+	void updateHotClusters();
+
+	/// Point the cluster to the contact probabilities for its size (after a change in membership).
+	void updateContactProbabilities(Cluster& cluster);
+
 private:
 	unsigned int m_num_threads;          ///< The number of threads(as a hint)
 
-	#if UNIPAR_IMPL == UNIPAR_DUMMY
-	using RandomRef = util::Random*;
-	#else
-	using RandomRef = std::unique_ptr<util::Random>;
-	#endif
+	Parallel m_parallel;
 
-	decltype(Parallel().with<RandomRef>()) m_parallel;
-
-	std::shared_ptr<util::Random> m_rng;
+	std::shared_ptr<util::Random> m_rng;     ///< Random numbers, also seeds the streams of the clusters every day.
 	LogMode m_log_level;            ///< Specifies logging mode.
+	ContactSampling m_contact_sampling;   ///< Specifies how transmissions are sampled in the clusters.
+	ClusterScheduling m_cluster_scheduling;   ///< Specifies how the clusters are divided over the threads.
+	bool m_hot_clusters_only;             ///< Only visit the clusters with infectious members (when nothing happens in the others).
 	std::shared_ptr<Calendar> m_calendar;             ///< Management of calendar.
 
 private:
@@ -185,6 +196,15 @@ private:
 
 	std::vector<District> m_districts;    ///< Container with districts (villages and cities).
 
+	/// Locations of the clusters by type (only the types that host travellers), see chooseCluster.
+	std::array<util::GeoGrid, numOfClusterTypes()> m_cluster_grids;
+
+	std::array<std::vector<std::size_t>, numOfClusterTypes()> m_hot_clusters;  ///< Clusters with infectious members, by type.
+	std::array<std::vector<unsigned int>, numOfClusterTypes()> m_hot_cluster_cases;  ///< Number of infectious members of the hot clusters.
+
+	/// Contact probabilities of the clusters by type, filled in when the membership changes (never during a time step).
+	std::array<ContactProbabilityTable, numOfClusterTypes()> m_contact_probabilities;
+
 	std::map<string, AsyncSimulator*> m_communication_map;    ///< Communication between the simulator and the senders
 
 	DiseaseProfile m_disease_profile;      ///< Profile of disease.
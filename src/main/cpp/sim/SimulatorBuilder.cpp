@@ -25,8 +25,8 @@
 #include "pop/Population.h"
 #include "pop/PopulationBuilder.h"
 #include "util/InstallDirs.h"
+#include "util/MappedCsv.h"
 #include "util/GeoCoordinate.h"
-#include "util/StringUtils.h"
 #include "util/TransportFacilityReader.h"
 #include "core/Cluster.h"
 #include "core/ClusterType.h"
@@ -96,6 +96,19 @@ shared_ptr<Simulator> SimulatorBuilder::build(const ptree& pt_config,
 	sim->m_log_level = isLogMode(l) ? toLogMode(l) : throw runtime_error(
 			string(__func__) + "> Invalid input for LogMode.");
 
+	// get contact sampling.
+	const string s = pt_config.get<string>("run.contact_sampling", "Pairwise");
+	sim->m_contact_sampling = isContactSampling(s) ? toContactSampling(s) : throw runtime_error(
+			string(__func__) + "> Invalid input for ContactSampling.");
+
+	// get cluster scheduling.
+	const string cs = pt_config.get<string>("run.cluster_scheduling", "PerType");
+	sim->m_cluster_scheduling = isClusterScheduling(cs) ? toClusterScheduling(cs) : throw runtime_error(
+			string(__func__) + "> Invalid input for ClusterScheduling.");
+
+	// visit only the clusters with infectious members (when nothing can happen in the others).
+	sim->m_hot_clusters_only = pt_config.get("run.hot_clusters_only", true);
+
 	// Rng's.
 	int seed = pt_config.get<int>("run.regions.region.rng_seed");
 	sim->m_rng = make_shared<util::Random>(seed);
@@ -104,11 +117,12 @@ shared_ptr<Simulator> SimulatorBuilder::build(const ptree& pt_config,
 	ptree pt_pop;
 	if (pt_config.get("run.regions.region.population", "") == "") {
 		pt_pop.put("population.people", pt_config.get<string>("run.regions.region.raw_population"));
+		pt_pop.put("population.format", pt_config.get<string>("run.regions.region.raw_population.<xmlattr>.format", "csv"));
 	} else {
 		read_xml((InstallDirs::getDataDir() / pt_config.get<string>("run.regions.region.population")).string(),
 				 pt_pop, xml_parser::trim_whitespace);
 	}
-	sim->m_population = PopulationBuilder::build(pt_config, pt_disease, pt_pop, *sim->m_rng);
+	sim->m_population = PopulationBuilder::build(pt_config, pt_disease, pt_pop, *sim->m_rng, sim->m_parallel);
 	sim->m_config_pop = pt_pop;
 
 	// Get the next id for new travellers
@@ -120,14 +134,6 @@ shared_ptr<Simulator> SimulatorBuilder::build(const ptree& pt_config,
 
 	sim->m_next_id = max_id + 1;
 
-	// Get the new household id for travellers
-	max_id = 0;
-	for (auto& hh: sim->m_households) {
-		max_id = std::max(uint(max_id), uint(hh.getId()));
-	}
-
-	sim->m_next_hh_id = max_id + 1;
-
 	// Initialize districts.
 	initializeDistricts(sim, pt_pop);
 
@@ -137,6 +143,14 @@ shared_ptr<Simulator> SimulatorBuilder::build(const ptree& pt_config,
 	// Initialize clusters.
 	initializeClusters(sim, pt_pop);
 
+	// Get the new household id for travellers (past the last household, they are not in one)
+	max_id = 0;
+	for (auto& hh: sim->m_households) {
+		max_id = std::max(uint(max_id), uint(hh.getId()));
+	}
+
+	sim->m_next_hh_id = max_id + 1;
+
 	// initialize disease profile.
 	sim->m_disease_profile.initialize(pt_config, pt_disease);
 
@@ -149,6 +163,14 @@ shared_ptr<Simulator> SimulatorBuilder::build(const ptree& pt_config,
 	Cluster::addContactProfile(ClusterType::SecondaryCommunity,
 							   ContactProfile(ClusterType::SecondaryCommunity, pt_contact));
 
+	// Contact probabilities of the clusters (by type and size), so they need no lock during the time steps.
+	for (auto clusters: {&sim->m_households, &sim->m_school_clusters, &sim->m_work_clusters,
+						 &sim->m_primary_community, &sim->m_secondary_community}) {
+		for (auto& cluster: *clusters) {
+			sim->updateContactProbabilities(cluster);
+		}
+	}
+
 	// Done.
 	return sim;
 }
@@ -182,59 +204,79 @@ void SimulatorBuilder::initializeClusters(shared_ptr<Simulator> sim, const boost
 		cluster_filename = pt_config.get<string>("population.clusters");
 	}
 
-	map<pair<ClusterType, uint>, GeoCoordinate> locations = initializeLocations(cluster_filename);
+	const Locations locations = initializeLocations(cluster_filename,
+													{{max_id_households + 1, max_id_school_clusters + 1,
+													  max_id_work_clusters + 1, max_id_primary_community + 1,
+													  max_id_secondary_community + 1}},
+													sim->m_parallel);
 
+	const auto& household_locations = locations[toSizeType(ClusterType::Household)];
+	sim->m_households.reserve(household_locations.size());
 	for (size_t i = 0; i <= max_id_households; i++) {
 		sim->m_households.emplace_back(
-				Cluster(cluster_id, ClusterType::Household, locations[make_pair(ClusterType::Household, i)]));
+				Cluster(cluster_id, ClusterType::Household, &population, household_locations[i]));
 		cluster_id++;
 	}
+	const auto& school_locations = locations[toSizeType(ClusterType::School)];
+	sim->m_school_clusters.reserve(school_locations.size());
 	for (size_t i = 0; i <= max_id_school_clusters; i++) {
 		sim->m_school_clusters.emplace_back(
-				Cluster(cluster_id, ClusterType::School, locations[make_pair(ClusterType::School, i)]));
+				Cluster(cluster_id, ClusterType::School, &population, school_locations[i]));
 		cluster_id++;
 	}
+	const auto& work_locations = locations[toSizeType(ClusterType::Work)];
+	sim->m_work_clusters.reserve(work_locations.size());
 	for (size_t i = 0; i <= max_id_work_clusters; i++) {
 		sim->m_work_clusters.emplace_back(
-				Cluster(cluster_id, ClusterType::Work, locations[make_pair(ClusterType::Work, i)]));
+				Cluster(cluster_id, ClusterType::Work, &population, work_locations[i]));
 		cluster_id++;
 	}
+	const auto& primary_community_locations = locations[toSizeType(ClusterType::PrimaryCommunity)];
+	sim->m_primary_community.reserve(primary_community_locations.size());
 	for (size_t i = 0; i <= max_id_primary_community; i++) {
-		sim->m_primary_community.emplace_back(Cluster(cluster_id, ClusterType::PrimaryCommunity,
-													  locations[make_pair(ClusterType::PrimaryCommunity, i)]));
+		sim->m_primary_community.emplace_back(Cluster(cluster_id, ClusterType::PrimaryCommunity, &population,
+													  primary_community_locations[i]));
 		cluster_id++;
 	}
+	const auto& secondary_community_locations = locations[toSizeType(ClusterType::SecondaryCommunity)];
+	sim->m_secondary_community.reserve(secondary_community_locations.size());
 	for (size_t i = 0; i <= max_id_secondary_community; i++) {
-		sim->m_secondary_community.emplace_back(Cluster(cluster_id, ClusterType::SecondaryCommunity,
-														locations[make_pair(ClusterType::SecondaryCommunity, i)]));
+		sim->m_secondary_community.emplace_back(Cluster(cluster_id, ClusterType::SecondaryCommunity, &population,
+														secondary_community_locations[i]));
 		cluster_id++;
 	}
 
 	// TODO add cities and villages
 
+	// Travellers are put in clusters near their destination, see Simulator::chooseCluster.
+	for (const auto type: {ClusterType::Work, ClusterType::PrimaryCommunity, ClusterType::SecondaryCommunity}) {
+		sim->m_cluster_grids[toSizeType(type)] = GeoGrid(locations[toSizeType(type)]);
+	}
+
 	// Cluster id '0' means "not present in any cluster of that type".
-	for (auto& p: population) {
-		const auto hh_id = p.getClusterId(ClusterType::Household);
-		if (hh_id > 0) {
-			sim->m_households[hh_id].addPerson(&p);
-		}
-		const auto sc_id = p.getClusterId(ClusterType::School);
-		if (sc_id > 0) {
-			sim->m_school_clusters[sc_id].addPerson(&p);
+	// Clusters refer to their members by index in the population (see PersonIndex).
+	// Members are counted first so every cluster allocates its members once, the cluster types are independent.
+	const auto& persons = population.m_original;
+	vector<Cluster>* clusters_of_type[] = {&sim->m_households, &sim->m_school_clusters, &sim->m_work_clusters,
+										   &sim->m_primary_community, &sim->m_secondary_community};
+	sim->m_parallel.for_(0U, numOfClusterTypes(), [&](size_t type_index) {
+		const auto type = static_cast<ClusterType>(type_index);
+		auto& clusters = *clusters_of_type[type_index];
+
+		vector<PersonIndex> num_members(clusters.size(), 0U);
+		for (const auto& p: persons) {
+			num_members[p.getClusterId(type)]++;
 		}
-		const auto wo_id = p.getClusterId(ClusterType::Work);
-		if (wo_id > 0) {
-			sim->m_work_clusters[wo_id].addPerson(&p);
+		for (size_t id = 1; id < clusters.size(); id++) {
+			clusters[id].reserveMembers(num_members[id]);
 		}
-		const auto primCom_id = p.getClusterId(ClusterType::PrimaryCommunity);
-		if (primCom_id > 0) {
-			sim->m_primary_community[primCom_id].addPerson(&p);
-		}
-		const auto secCom_id = p.getClusterId(ClusterType::SecondaryCommunity);
-		if (secCom_id > 0) {
-			sim->m_secondary_community[secCom_id].addPerson(&p);
+		for (PersonIndex i = 0; i < persons.size(); i++) {
+			const auto id = persons[i].getClusterId(type);
+			if (id > 0) {
+				clusters[id].addPerson(i);
+			}
 		}
-	}
+	});
 }
 
 void SimulatorBuilder::initializeDistricts(shared_ptr<Simulator> sim, const boost::property_tree::ptree& pt_config) {
@@ -254,43 +296,39 @@ void SimulatorBuilder::initializeDistricts(shared_ptr<Simulator> sim, const boos
 								+ ">Districts file " + file_path.string() + " not present. Aborting.");
 		}
 
-		// Open the file
-		boost::filesystem::ifstream districts_file;
-		districts_file.open(file_path.string());
-		if (!districts_file.is_open()) {
-			throw runtime_error(string(__func__)
-								+ "> Error opening districts file " + file_path.string());
-		}
-
-		// Parse the file and fill the map
-		string line;
-		getline(districts_file, line); // step over file header
-
-		while (getline(districts_file, line)) {
-			auto values = StringUtils::split(line, ",");
-
-			// Remove the quotes
-			values[1].erase(values[1].begin());
-			values[1].erase(values[1].end() - 1);
+		// Parse the file (the field parser removes the quotes around the name)
+		const auto districts = MappedCsv(file_path.string()).parse<pair<string, GeoCoordinate>>(
+				[&](const MappedCsv::Field* values, size_t num_values) {
+					if (num_values < 8) {
+						throw runtime_error("initializeDistricts> Bad line in districts file " + file_path.string());
+					}
+					return make_pair(values[1].toString(), GeoCoordinate(values[6].toDouble(), values[7].toDouble()));
+				}, sim->m_parallel);
 
+		for (const auto& values: districts) {
 			// Check for duplicates
-			auto search_duplicate = [&](const District& district) { return district.getName() == values[1]; };
+			auto search_duplicate = [&](const District& district) { return district.getName() == values.first; };
 			if (find_if(sim->m_districts.cbegin(), sim->m_districts.cend(), search_duplicate) ==
 				sim->m_districts.cend()) {
-				sim->m_districts.push_back(District(values[1],
+				sim->m_districts.push_back(District(values.first,
 													influence_size,
 													influence_speed,
 													influence_minimum,
-													GeoCoordinate(StringUtils::fromString<double>(values[6]),
-																  StringUtils::fromString<double>(values[7]))));
+													values.second));
 			}
 		}
 	}
 }
 
 
-map<pair<ClusterType, uint>, GeoCoordinate> SimulatorBuilder::initializeLocations(string filename) {
-	map<pair<ClusterType, uint>, GeoCoordinate> cluster_locations;
+SimulatorBuilder::Locations SimulatorBuilder::initializeLocations(string filename,
+																 const array<size_t, numOfClusterTypes()>& num_clusters,
+																 Parallel& parallel) {
+	// Cluster ids are dense, so the coordinates are indexed by id. Clusters without a location are in the origin.
+	Locations cluster_locations;
+	for (size_t type = 0; type < numOfClusterTypes(); type++) {
+		cluster_locations[type].resize(num_clusters[type]);
+	}
 
 	if (filename != "") {
 		// Check for the correctness of the file
@@ -300,25 +338,30 @@ map<pair<ClusterType, uint>, GeoCoordinate> SimulatorBuilder::initializeLocation
 								+ ">Cluster location file " + file_path.string() + " not present. Aborting.");
 		}
 
-		// Open the file
-		boost::filesystem::ifstream locations_file;
-		locations_file.open(file_path.string());
-		if (!locations_file.is_open()) {
-			throw runtime_error(string(__func__)
-								+ "> Error opening cluster location file " + file_path.string());
-		}
-
-		// Parse the file and fill the map
-		string line;
-		getline(locations_file, line); // step over file header
-
-		while (getline(locations_file, line)) {
-			const auto values = StringUtils::split(line, ",");
-			// NOTE: if the values are invalid, it will be zero/Null due to StringUtils/ClusterType
-			cluster_locations[make_pair(toClusterType(values[1]),
-										StringUtils::fromString<unsigned int>(values[0]))] = GeoCoordinate(
-					StringUtils::fromString<double>(values[2]),
-					StringUtils::fromString<double>(values[3]));
+		// Parse the file and fill the tables
+		struct Location {
+			ClusterType type;
+			unsigned int id;
+			GeoCoordinate coordinate;
+		};
+		const auto locations = MappedCsv(file_path.string()).parse<Location>(
+				[&](const MappedCsv::Field* values, size_t num_values) {
+					if (num_values < 4) {
+						throw runtime_error("initializeLocations> Bad line in cluster location file "
+											+ file_path.string());
+					}
+					// NOTE: if the values are invalid, it will be zero/Null due to MappedCsv/ClusterType
+					return Location{toClusterType(values[1].toString()), values[0].toUnsigned(),
+									GeoCoordinate(values[2].toDouble(), values[3].toDouble())};
+				}, parallel);
+		for (const auto& location: locations) {
+			// Locations of unknown types or of clusters nobody belongs to are not needed.
+			if (location.type != ClusterType::Null) {
+				auto& table = cluster_locations[toSizeType(location.type)];
+				if (location.id < table.size()) {
+					table[location.id] = location.coordinate;
+				}
+			}
 		}
 	}
 	return cluster_locations;
@@ -24,10 +24,11 @@
 #include "util/GeoCoordinate.h"
 
 #include <boost/property_tree/ptree.hpp>
+#include <array>
 #include <memory>
 #include <string>
-#include <map>
 #include <utility>
+#include <vector>
 
 namespace stride {
 
@@ -62,10 +63,16 @@ private:
 			std::shared_ptr<Simulator> sim,
 			const boost::property_tree::ptree& pt_config);
 
+	/// Cluster coordinates per cluster type, indexed by cluster id.
+	using Locations = std::array<std::vector<util::GeoCoordinate>, numOfClusterTypes()>;
+
 	/// Initialize the locations (read the from the given file) and return them
 	/// If the filename is "", it will assume that you use an older version of stride which has no locations, all locations will be in the origin (0,0)
 	/// Unreadable input will result in zeroes/ClusterType::Null
-	static std::map<std::pair<ClusterType, uint>, util::GeoCoordinate> initializeLocations(std::string filename);
+	/// @param num_clusters   Number of clusters (largest id + 1) per cluster type, other ids are ignored.
+	static Locations initializeLocations(std::string filename,
+										 const std::array<std::size_t, numOfClusterTypes()>& num_clusters,
+										 Parallel& parallel);
 
 	/// Initialize the facilities, duplicate facility names are ignored (only the first occurrence is counted)
 	/// Unknown districts are ignored
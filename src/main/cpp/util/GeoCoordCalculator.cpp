@@ -5,26 +5,112 @@ using namespace stride;
 using namespace util;
 using namespace std;
 
+/// Mean radius of the earth (in kilometres)
 double earth_radius = 6371;
 
-/// Mean radius of the earth (in metres)
 const GeoCoordCalculator& GeoCoordCalculator::getInstance() {
 	static GeoCoordCalculator calc;
 
 	return calc;
 }
 
+namespace {
+
+/// Room for rounding in the bounds of findWithin (relative).
+const double g_slack = 1e-9;
+
+/// The cosine of a latitude (in degrees).
+inline double cosLatitude(double latitude) {
+	return cos(latitude * PI / 180.0);
+}
+
+/// The haversine of the angle between two coordinates, given the cosines of their latitudes.
+inline double haversine(double latitude1, double longitude1, double cos_latitude1,
+		double latitude2, double longitude2, double cos_latitude2) {
+	const double sin_latitude = sin((latitude2 - latitude1) * PI / 360.0);
+	const double sin_longitude = sin((longitude2 - longitude1) * PI / 360.0);
+
+	return sin_latitude * sin_latitude + cos_latitude1 * cos_latitude2 * sin_longitude * sin_longitude;
+}
+
+/// The distance (in km) that belongs to a haversine.
+inline double toDistance(double haversine) {
+	return earth_radius * (2.0 * asin(min(1.0, sqrt(haversine))));
+}
+
+}
+
+GeoCoordBatch::GeoCoordBatch(const vector<GeoCoordinate>& coords) {
+	m_latitudes.reserve(coords.size());
+	m_longitudes.reserve(coords.size());
+	m_cos_latitudes.reserve(coords.size());
+	for (const auto& coord: coords) {
+		push_back(coord);
+	}
+}
+
+void GeoCoordBatch::push_back(const GeoCoordinate& coord) {
+	m_latitudes.push_back(coord.m_latitude);
+	m_longitudes.push_back(coord.m_longitude);
+	m_cos_latitudes.push_back(cosLatitude(coord.m_latitude));
+}
+
 double GeoCoordCalculator::getDistance(const GeoCoordinate& coord1, const GeoCoordinate& coord2) const {
-	double delta_latitude = coord2.m_latitude - coord1.m_latitude;
-	double delta_longitude = coord2.m_longitude - coord1.m_longitude;
+	return toDistance(haversine(coord1.m_latitude, coord1.m_longitude, cosLatitude(coord1.m_latitude),
+								coord2.m_latitude, coord2.m_longitude, cosLatitude(coord2.m_latitude)));
+}
 
-	double temp1 = sin(delta_latitude * PI / 360.0) * sin(delta_latitude * PI / 360.0) +
-				   cos(coord1.m_latitude * PI / 180.0) * cos(coord2.m_latitude * PI / 180.0) *
-				   sin(delta_longitude * PI / 360.0) * sin(delta_longitude * PI / 360.0);
+void GeoCoordCalculator::getDistances(const GeoCoordinate& origin, const GeoCoordBatch& coords, size_t first,
+		size_t last, double* distances) const {
+	const double cos_origin = cosLatitude(origin.m_latitude);
+	const double* latitudes = coords.m_latitudes.data();
+	const double* longitudes = coords.m_longitudes.data();
+	const double* cos_latitudes = coords.m_cos_latitudes.data();
+	for (size_t i = first; i < last; i++) {
+		distances[i - first] = toDistance(haversine(origin.m_latitude, origin.m_longitude, cos_origin,
+													latitudes[i], longitudes[i], cos_latitudes[i]));
+	}
+}
 
-	double temp2 = 2.0 * asin(min(1.0, sqrt(temp1)));
+void GeoCoordCalculator::getDistances(const GeoCoordBatch& origins, const GeoCoordBatch& coords,
+		vector<double>& distances) const {
+	distances.resize(origins.size() * coords.size());
+	for (size_t i = 0; i < origins.size(); i++) {
+		const GeoCoordinate origin(origins.m_latitudes[i], origins.m_longitudes[i]);
+		getDistances(origin, coords, 0, coords.size(), distances.data() + i * coords.size());
+	}
+}
 
-	return earth_radius * temp2;
+void GeoCoordCalculator::findWithin(const GeoCoordinate& origin, double radius, const GeoCoordBatch& coords,
+		size_t first, size_t last, vector<unsigned int>& positions, vector<double>* distances) const {
+	// A coordinate is never closer than its difference in latitude (the north-south side of the
+	// equirectangular projection), and the haversine grows with the distance up to half the circumference.
+	const double angle = radius / earth_radius;
+	const double max_delta_latitude = angle * 180.0 / PI * (1.0 + g_slack);
+	const bool check_haversine = angle < PI;
+	const double max_haversine = sin(angle / 2.0) * sin(angle / 2.0) * (1.0 + g_slack);
+
+	const double cos_origin = cosLatitude(origin.m_latitude);
+	const double* latitudes = coords.m_latitudes.data();
+	const double* longitudes = coords.m_longitudes.data();
+	const double* cos_latitudes = coords.m_cos_latitudes.data();
+	for (size_t i = first; i < last; i++) {
+		if (fabs(latitudes[i] - origin.m_latitude) > max_delta_latitude) {
+			continue;
+		}
+		const double temp1 = haversine(origin.m_latitude, origin.m_longitude, cos_origin,
+									   latitudes[i], longitudes[i], cos_latitudes[i]);
+		if (check_haversine && temp1 > max_haversine) {
+			continue;
+		}
+		const double distance = toDistance(temp1);
+		if (distance <= radius) {
+			positions.push_back(static_cast<unsigned int>(i));
+			if (distances != nullptr) {
+				distances->push_back(distance);
+			}
+		}
+	}
 }
 
 void GeoCoordCalculator::convertToRegularCoordinates(double& latitude, double& longitude) const {
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <random>
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
 #include "util/GeoCoordinate.h"
 
@@ -11,6 +13,22 @@ namespace util {
 
 using namespace std;
 
+/// Coordinates as separate arrays of latitudes and longitudes, with the cosine of the latitudes
+/// computed once, for the batch functions of GeoCoordCalculator.
+struct GeoCoordBatch {
+	GeoCoordBatch() {}
+
+	explicit GeoCoordBatch(const vector<GeoCoordinate>& coords);
+
+	void push_back(const GeoCoordinate& coord);
+
+	size_t size() const { return m_latitudes.size(); }
+
+	vector<double> m_latitudes;
+	vector<double> m_longitudes;
+	vector<double> m_cos_latitudes;
+};
+
 class GeoCoordCalculator {
 	/// Singleton pattern
 public:
@@ -21,6 +39,21 @@ public:
 	/// Uses the haversine formula
 	/// See: http://www.movable-type.co.uk/scripts/latlong.html
 
+	/// The distances from the origin to the coordinates first, ..., last - 1 of the batch, in distances[0], ...
+	/// The results are the same as those of getDistance.
+	void getDistances(const GeoCoordinate& origin, const GeoCoordBatch& coords, size_t first, size_t last,
+			double* distances) const;
+
+	/// The distances from every origin to every coordinate, one row (of coords.size() values) per origin.
+	void getDistances(const GeoCoordBatch& origins, const GeoCoordBatch& coords, vector<double>& distances) const;
+
+	/// Append the positions of the coordinates first, ..., last - 1 of the batch that lie within radius (km)
+	/// of the origin, and their distances if distances is not null.
+	/// Gives the same coordinates as comparing getDistance with the radius, but the ones too far north or south
+	/// are rejected without any trigonometry, and the others before the arcsine.
+	void findWithin(const GeoCoordinate& origin, double radius, const GeoCoordBatch& coords, size_t first,
+			size_t last, vector<unsigned int>& positions, vector<double>* distances = nullptr) const;
+
 	template<class T>
 	GeoCoordinate generateRandomCoord(
 			const GeoCoordinate& coord,
@@ -0,0 +1,163 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Implementation of the GeoGrid class.
+ */
+
+#include "GeoGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace stride {
+namespace util {
+
+using namespace std;
+
+namespace {
+
+/// Mean radius of the earth in km, as in GeoCoordCalculator.
+const double g_earth_radius = 6371.0;
+
+/// Extra room around the bounding box of a query (in degrees), against rounding.
+const double g_margin = 1e-6;
+
+}
+
+GeoGrid::GeoGrid()
+		: m_min_latitude(0.0), m_min_longitude(0.0), m_cell_size(1.0), m_rows(0U), m_columns(0U) {}
+
+GeoGrid::GeoGrid(const vector<GeoCoordinate>& points, double points_per_cell)
+		: m_points(points), m_min_latitude(0.0), m_min_longitude(0.0), m_cell_size(1.0), m_rows(0U),
+		  m_columns(0U) {
+	if (m_points.empty()) {
+		return;
+	}
+	double max_latitude = m_points[0].m_latitude;
+	double max_longitude = m_points[0].m_longitude;
+	m_min_latitude = max_latitude;
+	m_min_longitude = max_longitude;
+	for (const auto& point: m_points) {
+		m_min_latitude = min(m_min_latitude, point.m_latitude);
+		m_min_longitude = min(m_min_longitude, point.m_longitude);
+		max_latitude = max(max_latitude, point.m_latitude);
+		max_longitude = max(max_longitude, point.m_longitude);
+	}
+
+	// Square cells for about points_per_cell points each, but not more cells along one side than that
+	// (for points that lie on a line).
+	const double height = max_latitude - m_min_latitude;
+	const double width = max_longitude - m_min_longitude;
+	const double num_cells = max(1.0, m_points.size() / points_per_cell);
+	m_cell_size = max(sqrt(height * width / num_cells), max(height, width) / num_cells);
+	if (m_cell_size <= 0.0) {
+		m_cell_size = 1.0;
+	}
+	m_rows = static_cast<unsigned int>(height / m_cell_size) + 1U;
+	m_columns = static_cast<unsigned int>(width / m_cell_size) + 1U;
+
+	// Counting sort of the points by cell, so the points of a cell are in increasing order.
+	vector<unsigned int> cell_of_point(m_points.size());
+	m_cell_start.assign(static_cast<size_t>(m_rows) * m_columns + 1, 0U);
+	for (size_t i = 0; i < m_points.size(); i++) {
+		cell_of_point[i] = toCell(m_points[i].m_latitude, m_min_latitude, m_rows) * m_columns
+						   + toCell(m_points[i].m_longitude, m_min_longitude, m_columns);
+		m_cell_start[cell_of_point[i] + 1]++;
+	}
+	for (size_t cell = 1; cell < m_cell_start.size(); cell++) {
+		m_cell_start[cell] += m_cell_start[cell - 1];
+	}
+	m_cell_points.resize(m_points.size());
+	vector<unsigned int> next(m_cell_start.begin(), m_cell_start.end() - 1);
+	for (size_t i = 0; i < m_points.size(); i++) {
+		m_cell_points[next[cell_of_point[i]]++] = i;
+	}
+	for (const unsigned int index: m_cell_points) {
+		m_cell_coords.push_back(m_points[index]);
+	}
+}
+
+void GeoGrid::findWithin(const GeoCoordinate& center, double radius, vector<unsigned int>& result) const {
+	findInCells(center, radius, result, nullptr);
+	for (auto& index: result) {
+		index = m_cell_points[index];
+	}
+	sort(result.begin(), result.end());
+}
+
+void GeoGrid::findWithin(const GeoCoordinate& center, double radius, vector<unsigned int>& result,
+		vector<double>& distances) const {
+	vector<double> cell_distances;
+	findInCells(center, radius, result, &cell_distances);
+	vector<pair<unsigned int, double>> found(result.size());
+	for (size_t i = 0; i < result.size(); i++) {
+		found[i] = make_pair(m_cell_points[result[i]], cell_distances[i]);
+	}
+	sort(found.begin(), found.end());
+	distances.resize(found.size());
+	for (size_t i = 0; i < found.size(); i++) {
+		result[i] = found[i].first;
+		distances[i] = found[i].second;
+	}
+}
+
+void GeoGrid::findInCells(const GeoCoordinate& center, double radius, vector<unsigned int>& positions,
+		vector<double>* distances) const {
+	positions.clear();
+	if (m_points.empty()) {
+		return;
+	}
+
+	// Bounding box of the circle: the latitude differs at most the angle of the radius, the longitude
+	// at most asin(sin(angle) / cos(latitude)), unless the circle holds a pole.
+	const double angle = radius / g_earth_radius;
+	const double delta_latitude = angle * 180.0 / PI + g_margin;
+	unsigned int first_column = 0U;
+	unsigned int last_column = m_columns - 1;
+	const double cos_latitude = cos(center.m_latitude * PI / 180.0);
+	if (angle < PI / 2.0 && sin(angle) < cos_latitude) {
+		const double delta_longitude = asin(sin(angle) / cos_latitude) * 180.0 / PI + g_margin;
+		// Around the date line the whole width is searched.
+		if (center.m_longitude - delta_longitude >= -180.0 && center.m_longitude + delta_longitude <= 180.0) {
+			first_column = toCell(center.m_longitude - delta_longitude, m_min_longitude, m_columns);
+			last_column = toCell(center.m_longitude + delta_longitude, m_min_longitude, m_columns);
+		}
+	}
+	const unsigned int first_row = toCell(center.m_latitude - delta_latitude, m_min_latitude, m_rows);
+	const unsigned int last_row = toCell(center.m_latitude + delta_latitude, m_min_latitude, m_rows);
+
+	// The cells of a row in the box are adjacent, so are their points.
+	const auto& calc = GeoCoordCalculator::getInstance();
+	for (unsigned int row = first_row; row <= last_row; row++) {
+		const unsigned int first_cell = row * m_columns + first_column;
+		const unsigned int last_cell = row * m_columns + last_column;
+		calc.findWithin(center, radius, m_cell_coords, m_cell_start[first_cell], m_cell_start[last_cell + 1],
+						positions, distances);
+	}
+}
+
+unsigned int GeoGrid::toCell(double value, double min_value, unsigned int num_cells) const {
+	const double cell = floor((value - min_value) / m_cell_size);
+	if (cell <= 0.0) {
+		return 0U;
+	}
+	return cell >= num_cells - 1 ? num_cells - 1 : static_cast<unsigned int>(cell);
+}
+
+}
+}
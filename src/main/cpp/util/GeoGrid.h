@@ -0,0 +1,78 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Header for the GeoGrid class.
+ */
+
+#include "util/GeoCoordCalculator.h"
+#include "util/GeoCoordinate.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace stride {
+namespace util {
+
+/**
+ * Spatial index of points on the earth: a grid of cells of equal size in latitude and longitude.
+ * A radius query only looks at the points in the cells that overlap the bounding box of the circle,
+ * and keeps the ones within the radius (the haversine distance of GeoCoordCalculator).
+ */
+class GeoGrid {
+public:
+	/// Empty grid.
+	GeoGrid();
+
+	/// Index the points (by their position in the vector), with about points_per_cell points in a cell.
+	explicit GeoGrid(const std::vector<GeoCoordinate>& points, double points_per_cell = 4.0);
+
+	/// Put the indices of the points within radius (km) of the center in result, in increasing order.
+	void findWithin(const GeoCoordinate& center, double radius, std::vector<unsigned int>& result) const;
+
+	/// As above, and put the distances (km) of those points in distances.
+	void findWithin(const GeoCoordinate& center, double radius, std::vector<unsigned int>& result,
+			std::vector<double>& distances) const;
+
+	/// Number of points in the grid.
+	std::size_t size() const { return m_points.size(); }
+
+	/// The point with the given index.
+	const GeoCoordinate& getPoint(std::size_t index) const { return m_points[index]; }
+
+private:
+	/// Row or column of the cell with the given latitude or longitude (clamped to the grid).
+	unsigned int toCell(double value, double min_value, unsigned int num_cells) const;
+
+	/// Positions (in m_cell_points) and distances of the points within radius of the center, by cell.
+	void findInCells(const GeoCoordinate& center, double radius, std::vector<unsigned int>& positions,
+			std::vector<double>* distances) const;
+
+private:
+	std::vector<GeoCoordinate> m_points;
+	double m_min_latitude;
+	double m_min_longitude;
+	double m_cell_size;                      ///< In degrees, the same for latitude and longitude.
+	unsigned int m_rows;
+	unsigned int m_columns;
+	std::vector<unsigned int> m_cell_start;  ///< Start of the points of cell (row * m_columns + column).
+	std::vector<unsigned int> m_cell_points; ///< Indices of the points, by cell.
+	GeoCoordBatch m_cell_coords;             ///< The points in the order of m_cell_points.
+};
+
+}
+}
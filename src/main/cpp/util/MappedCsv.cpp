@@ -0,0 +1,125 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Implementation of the MappedCsv class.
+ */
+
+#include "MappedCsv.h"
+
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace stride {
+namespace util {
+
+using namespace std;
+using namespace boost::interprocess;
+
+namespace {
+
+/// Size of the chunks of a file that are parsed in one go.
+const size_t g_chunk_size = 1U << 20U;
+
+}
+
+MappedCsv::Field::Field(const char* begin, const char* end)
+		: m_begin(begin), m_end(end) {
+	while (m_begin < m_end && *m_begin == ' ') {
+		++m_begin;
+	}
+	if (m_end - m_begin >= 2 && *m_begin == '"' && *(m_end - 1) == '"') {
+		++m_begin;
+		--m_end;
+	}
+}
+
+unsigned int MappedCsv::Field::toUnsigned() const {
+	unsigned int value = 0U;
+	for (const char* c = m_begin; c < m_end && *c >= '0' && *c <= '9'; ++c) {
+		value = value * 10U + static_cast<unsigned int>(*c - '0');
+	}
+	return value;
+}
+
+double MappedCsv::Field::toDouble() const {
+	// strtod needs a terminated string, the mapped file has none.
+	char buffer[64];
+	const size_t length = min(static_cast<size_t>(m_end - m_begin), sizeof(buffer) - 1);
+	memcpy(buffer, m_begin, length);
+	buffer[length] = '\0';
+	return strtod(buffer, nullptr);
+}
+
+MappedCsv::MappedCsv(const string& file_name)
+		: m_file_name(file_name), m_begin(nullptr), m_end(nullptr) {
+	// An empty file cannot be mapped (nor has it lines).
+	if (boost::filesystem::file_size(file_name) == 0U) {
+		return;
+	}
+	try {
+		m_file = file_mapping(file_name.c_str(), read_only);
+		m_region = mapped_region(m_file, read_only);
+	} catch (interprocess_exception& e) {
+		throw runtime_error(string(__func__) + "> Error mapping csv file " + file_name + ": " + e.what());
+	}
+	const char* data = static_cast<const char*>(m_region.get_address());
+	m_end = data + m_region.get_size();
+	lineEnd(data, m_end, m_begin);  // step over the header
+}
+
+vector<pair<const char*, const char*>> MappedCsv::getChunks() const {
+	vector<pair<const char*, const char*>> chunks;
+	const char* begin = m_begin;
+	while (begin < m_end) {
+		const char* end = begin + min(g_chunk_size, static_cast<size_t>(m_end - begin));
+		// Finish the line the chunk ends in.
+		end = find(end - 1, m_end, '\n');
+		end = (end == m_end) ? m_end : end + 1;
+		chunks.emplace_back(begin, end);
+		begin = end;
+	}
+	return chunks;
+}
+
+size_t MappedCsv::split(const char* begin, const char* end, Fields& fields) {
+	size_t num_fields = 0U;
+	const char* field = begin;
+	while (num_fields < fields.size()) {
+		const char* comma = find(field, end, ',');
+		fields[num_fields++] = Field(field, comma);
+		if (comma == end) {
+			break;
+		}
+		field = comma + 1;
+	}
+	return num_fields;
+}
+
+const char* MappedCsv::lineEnd(const char* begin, const char* end, const char*& next) {
+	const char* line_end = find(begin, end, '\n');
+	next = (line_end == end) ? end : line_end + 1;
+	if (line_end > begin && *(line_end - 1) == '\r') {
+		--line_end;
+	}
+	return line_end;
+}
+
+}
+}
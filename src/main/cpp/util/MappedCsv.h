@@ -0,0 +1,135 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Header for the MappedCsv class.
+ */
+
+#include "util/unipar.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stride {
+namespace util {
+
+/**
+ * Reader for large csv files (with a header line): the file is mapped into memory, cut in
+ * chunks at line ends and the chunks are parsed in parallel. The fields of a line are views
+ * on the mapped file and the numbers are converted in place, so parsing a line allocates
+ * nothing (unless the parser of the line does).
+ */
+class MappedCsv {
+public:
+	/// A field of a line, without the quotes.
+	class Field {
+	public:
+		Field() : m_begin(nullptr), m_end(nullptr) {}
+
+		Field(const char* begin, const char* end);
+
+		/// The field as an unsigned number (0 if it does not start with a digit).
+		unsigned int toUnsigned() const;
+
+		/// The field as a floating point number (0 if it is not a number).
+		double toDouble() const;
+
+		std::string toString() const { return std::string(m_begin, m_end); }
+
+	private:
+		const char* m_begin;
+		const char* m_end;
+	};
+
+	/// The fields of a line (the fields after the 16th are ignored).
+	using Fields = std::array<Field, 16U>;
+
+	/// Map the csv file with the given name.
+	explicit MappedCsv(const std::string& file_name);
+
+	/// Parse the lines after the header with parse_line(fields, num_fields), which returns a T.
+	/// The results are in the order of the file, whatever the number of threads.
+	template<typename T, typename ParseLine>
+	std::vector<T> parse(const ParseLine& parse_line, Parallel& parallel) const;
+
+private:
+	/// Split the body of the file in chunks of about the same size that end at a line end.
+	std::vector<std::pair<const char*, const char*>> getChunks() const;
+
+	/// Split the line [begin, end[ in fields, returns the number of fields.
+	static std::size_t split(const char* begin, const char* end, Fields& fields);
+
+	/// Get the end of the line that starts at begin (before the '\n' and a '\r').
+	static const char* lineEnd(const char* begin, const char* end, const char*& next);
+
+private:
+	std::string m_file_name;
+	boost::interprocess::file_mapping m_file;
+	boost::interprocess::mapped_region m_region;
+	const char* m_begin;    ///< Start of the body (after the header).
+	const char* m_end;      ///< End of the file.
+};
+
+template<typename T, typename ParseLine>
+std::vector<T> MappedCsv::parse(const ParseLine& parse_line, Parallel& parallel) const {
+	const auto chunks = getChunks();
+	std::vector<std::vector<T>> results(chunks.size());
+	std::vector<std::exception_ptr> errors(chunks.size());
+
+	parallel.for_(0U, chunks.size(), [&](std::size_t c) {
+		// Exceptions may not leave a parallel loop, the first one is thrown afterwards.
+		try {
+			Fields fields;
+			const char* line = chunks[c].first;
+			while (line < chunks[c].second) {
+				const char* next;
+				const char* end = lineEnd(line, chunks[c].second, next);
+				if (end != line) {
+					const std::size_t num_fields = split(line, end, fields);
+					results[c].push_back(parse_line(fields.data(), num_fields));
+				}
+				line = next;
+			}
+		} catch (...) {
+			errors[c] = std::current_exception();
+		}
+	});
+
+	std::size_t total = 0U;
+	for (std::size_t c = 0; c < chunks.size(); c++) {
+		if (errors[c]) {
+			std::rethrow_exception(errors[c]);
+		}
+		total += results[c].size();
+	}
+	std::vector<T> all;
+	all.reserve(total);
+	for (auto& result: results) {
+		std::move(result.begin(), result.end(), std::back_inserter(all));
+	}
+	return all;
+}
+
+}
+}
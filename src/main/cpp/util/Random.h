@@ -19,6 +19,8 @@
  * Header for the Random Number Generator class.
  */
 
+#include <cmath>
+#include <cstddef>
 #include <limits>
 
 #include <trng/mrg2.hpp>
@@ -47,8 +49,8 @@ public:
 		return m_uniform_dist(m_engine);
 	}
 
-	/// Get random unsigned int from [0, max[.
-	unsigned int operator()(unsigned int max = std::numeric_limits<unsigned int>::max()) {
+	/// Get random unsigned int from [0, max[ (the distribution works on int, hence the default).
+	unsigned int operator()(unsigned int max = std::numeric_limits<int>::max()) {
 		trng::uniform_int_dist dis(0, max);
 		return dis(m_engine);
 	}
@@ -63,10 +65,34 @@ public:
 		return nextDouble() < rateToProbability(transmission_rate);
 	}
 
+	/// Check if an event with the given probability happens.
+	bool hasSuccess(double probability) {
+		return nextDouble() < probability;
+	}
+
 	bool hasContactAndTransmission(double contact_rate, double transmission_rate) {
 		return nextDouble() < rateToProbability(transmission_rate * contact_rate);
 	}
 
+	/// Number of failures before the next success in a series of independent trials with
+	/// the given probability of success (geometric distribution), capped at max.
+	std::size_t nextGeometricSkip(double probability, std::size_t max) {
+		if (probability >= 1.0) {
+			return 0U;
+		}
+		if (probability <= 0.0) {
+			return max;
+		}
+		// 1 - u lies in ]0, 1], so the logarithm is finite.
+		const double skip = std::floor(std::log(1.0 - nextDouble()) / std::log1p(-probability));
+		return skip < max ? static_cast<std::size_t>(skip) : max;
+	}
+
+	/// Skip the given amount of random numbers (to split the sequence in disjoint streams).
+	void jump(unsigned long long steps) {
+		m_engine.jump(steps);
+	}
+
 	void setState(std::string state) {
 		std::stringstream ss;
 		ss.str(state);
@@ -0,0 +1,69 @@
+#pragma once
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2017, Willem L, Kuylen E, Stijven S & Broeckhove J
+ */
+
+/**
+ * @file
+ * Sampling without replacement.
+ */
+
+#include "util/Random.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace stride {
+namespace util {
+
+/// Move num_samples different elements, chosen at random, to the front of the candidates (partial Fisher-Yates
+/// shuffle). The remaining elements, the ones that were not chosen, end up behind them.
+/// Takes num_samples draws, however large the fraction of chosen candidates.
+template<typename T>
+void shuffleFront(std::vector<T>& candidates, std::size_t num_samples, Random& rng) {
+	if (num_samples > candidates.size()) {
+		throw std::runtime_error(std::string(__func__) + "> Cannot choose " + std::to_string(num_samples)
+								 + " out of " + std::to_string(candidates.size()) + " candidates.");
+	}
+	for (std::size_t i = 0; i < num_samples; i++) {
+		const std::size_t j = i + rng(candidates.size() - i);
+		std::swap(candidates[i], candidates[j]);
+	}
+}
+
+/// Choose num_samples different numbers from [0, size[ (Floyd's algorithm).
+/// Needs no table of candidates, meant for choosing a few out of many.
+inline std::vector<unsigned int> sampleIndices(unsigned int size, unsigned int num_samples, Random& rng) {
+	if (num_samples > size) {
+		throw std::runtime_error(std::string(__func__) + "> Cannot choose " + std::to_string(num_samples)
+								 + " out of " + std::to_string(size) + " numbers.");
+	}
+	std::vector<unsigned int> samples;
+	samples.reserve(num_samples);
+	std::unordered_set<unsigned int> chosen(2 * num_samples);
+	for (unsigned int j = size - num_samples; j < size; j++) {
+		const unsigned int t = rng(j + 1);
+		const unsigned int sample = chosen.insert(t).second ? t : j;
+		chosen.insert(sample);
+		samples.push_back(sample);
+	}
+	return samples;
+}
+
+}
+}
@@ -58,6 +58,11 @@ public:
 		}
 	}
 
+	template<typename IndexF, typename IndexL, typename Func, typename RM>
+	void parallelDynamicFor(IndexF first, IndexL last, const Func& f, RM& rm) {
+		parallelFor(first, last, IndexF(1), f, rm);
+	}
+
 	inline int getNumThreads() const { return 1; }
 };
 
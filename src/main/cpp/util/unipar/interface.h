@@ -32,6 +32,13 @@ public:
 	void parallelFor(IndexF first, IndexL last, IndexS step, const Func& f, RM& rm) {
 		throw std::logic_error("Please implement parallelFor");
 	}
+
+	// Like parallelFor, but the iterations are handed out one by one to idle
+	// threads, for loops where the iterations differ a lot in cost.
+	template<typename IndexF, typename IndexL, typename Func, typename RM>
+	void parallelDynamicFor(IndexF first, IndexL last, const Func& f, RM& rm) {
+		throw std::logic_error("Please implement parallelDynamicFor");
+	}
 };
 
 }
@@ -80,6 +80,14 @@ public:
 		}
 	}
 
+	template<typename IndexF, typename IndexL, typename Func, typename RM>
+	void parallelDynamicFor(IndexF first, IndexL last, const Func& f, RM& rm) {
+		#pragma omp parallel for num_threads(m_nthreads) schedule(dynamic, 1)
+		for (IndexF i = first; i < last; i++) {
+			rm.call(f, i);
+		}
+	}
+
 	inline int getNumThreads() const { return m_nthreads; }
 
 	inline void setNumThreads(int nthreads) { m_nthreads = nthreads; }
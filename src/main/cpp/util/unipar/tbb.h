@@ -3,7 +3,9 @@
 #include "unipar.h"
 #include "interface.h"
 
+#include "tbb/blocked_range.h"
 #include "tbb/parallel_for.h"
+#include "tbb/partitioner.h"
 #include "tbb/task_scheduler_init.h"
 #include "tbb/enumerable_thread_specific.h"
 
@@ -72,6 +74,23 @@ public:
 		}
 	}
 
+	// Every iteration is a task of its own, idle threads steal them from the busy ones.
+	template<typename IndexF, typename IndexL, typename Func, typename RM>
+	void parallelDynamicFor(IndexF first, IndexL last, const Func& f, RM& rm) {
+		using Largest = typename utils::largest<IndexF, IndexL>::type;
+		auto body = [&](const tbb::blocked_range<Largest>& range) {
+			for (Largest i = range.begin(); i < range.end(); i++) {
+				rm.call(f, i);
+			}
+		};
+		if (m_nthreads == -1) {
+			tbb::parallel_for(tbb::blocked_range<Largest>(first, last, 1), body, tbb::simple_partitioner());
+		} else {
+			tbb::task_scheduler_init init(m_nthreads);
+			tbb::parallel_for(tbb::blocked_range<Largest>(first, last, 1), body, tbb::simple_partitioner());
+		}
+	}
+
 	inline int getNumThreads() const {
 		if (m_nthreads == -1) {
 			return tbb::task_scheduler_init::default_num_threads();
@@ -98,6 +98,12 @@ public:
 		m_impl.parallelFor(first, last, step, f, m_resource_manager);
 	}
 
+	// For iterations of very different cost: these are handed out to idle threads one by one.
+	template<typename IndexF, typename IndexL, typename Func>
+	void dynamicFor_(IndexF first, IndexL last, const Func& f) {
+		m_impl.parallelDynamicFor(first, last, f, m_resource_manager);
+	}
+
 
 	// Resource management ................................
 
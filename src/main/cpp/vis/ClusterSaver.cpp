@@ -295,11 +295,12 @@ map<uint, uint> ClusterSaver::getAgeMap(const Simulator& local_sim) const {
 	map<uint, uint> result;
 
 	for (const auto& cluster: local_sim.getPrimaryCommunities()) {
-		for (const auto& person: cluster.getMembers()) {
-			if (result.find(person.first->getAge()) == result.end()) {
-				result[person.first->getAge()] = 0;
+		for (const auto& member: cluster.getMembers()) {
+			const auto age = cluster.getPopulation().getPerson(member).getAge();
+			if (result.find(age) == result.end()) {
+				result[age] = 0;
 			} else {
-				++result[person.first->getAge()];
+				++result[age];
 			}
 		}
 	}
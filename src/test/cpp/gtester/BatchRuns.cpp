@@ -31,6 +31,7 @@
 #include <map>
 #include <string>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace stride;
@@ -38,6 +39,95 @@ using namespace ::testing;
 
 namespace Tests {
 
+/// Configuration of the shorter runs that are compared with each other.
+boost::property_tree::ptree getComparisonConfig(unsigned int num_threads) {
+	boost::property_tree::ptree pt_config;
+	pt_config.put("run.<xmlattr>.name", "test");
+	pt_config.put("run.r0", 11.0);
+	pt_config.put("run.start_date", "2017-01-01");
+	pt_config.put("run.num_days", 20U);
+	pt_config.put("run.holidays", "holidays_none.json");
+	pt_config.put("run.age_contact_matrix_file", "contact_matrix_average.xml");
+	pt_config.put("run.num_threads", num_threads);
+	pt_config.put("run.outputs.log.<xmlattr>.level", "None");
+	pt_config.put("run.outputs.participants_survey.<xmlattr>.num", 10);
+	pt_config.put("run.disease.seeding_rate", 0.002);
+	pt_config.put("run.disease.immunity_rate", 0.8);
+	pt_config.put("run.disease.config", "disease_measles.xml");
+	pt_config.put("run.regions.region.rng_seed", 1U);
+	pt_config.put("run.regions.region.population", "bigpop.xml");
+	return pt_config;
+}
+
+/// Outcome of a run: the number of cases at the end of every day and the health of everyone at the end.
+struct RunOutcome {
+	vector<unsigned int> cases;
+	vector<HealthStatus> health;
+};
+
+/// Run the simulator with the given configuration.
+RunOutcome runSimulator(const boost::property_tree::ptree& pt_config) {
+	auto sim = SimulatorBuilder::build(pt_config);
+	RunOutcome outcome;
+	for (unsigned int day = 0; day < pt_config.get<unsigned int>("run.num_days"); day++) {
+		sim->timeStep();
+		outcome.cases.push_back(sim->getPopulation()->getInfectedCount());
+	}
+	const auto& population = *sim->getPopulation();
+	for (PersonIndex i = 0; i < population.getIndexCount(); i++) {
+		outcome.health.push_back(population.getHealthStatus(i));
+	}
+	return outcome;
+}
+
+TEST(Scenarios__ClusterVisits, HotClustersOnly) {
+	// Visiting only the clusters with infectious members changes nothing.
+	auto pt_config = getComparisonConfig(1U);
+	const auto hot_only = runSimulator(pt_config);
+	pt_config.put("run.hot_clusters_only", false);
+	const auto all = runSimulator(pt_config);
+
+	EXPECT_GT(hot_only.cases.back(), hot_only.cases.front());
+	EXPECT_EQ(all.cases, hot_only.cases);
+	EXPECT_TRUE(all.health == hot_only.health);
+}
+
+TEST(Scenarios__NumThreads, SameResults) {
+	// Every block of clusters draws from its own stream, the number of threads changes nothing.
+	const auto one_thread = runSimulator(getComparisonConfig(1U));
+	const auto four_threads = runSimulator(getComparisonConfig(4U));
+
+	EXPECT_GT(one_thread.cases.back(), one_thread.cases.front());
+	EXPECT_EQ(one_thread.cases, four_threads.cases);
+	EXPECT_TRUE(one_thread.health == four_threads.health);
+}
+
+TEST(Scenarios__ClusterScheduling, Balanced) {
+	// The balanced scheduling gives the same results for any number of threads.
+	auto pt_config = getComparisonConfig(1U);
+	pt_config.put("run.cluster_scheduling", "Balanced");
+	const auto one_thread = runSimulator(pt_config);
+	pt_config.put("run.num_threads", 4U);
+	const auto four_threads = runSimulator(pt_config);
+
+	EXPECT_GT(one_thread.cases.back(), one_thread.cases.front());
+	EXPECT_EQ(one_thread.cases, four_threads.cases);
+	EXPECT_TRUE(one_thread.health == four_threads.health);
+
+	// It draws in another order than the scheduling per type, but the distribution of the cases is the same.
+	const unsigned int num_runs = 8U;
+	double mean_balanced = 0.0;
+	double mean_per_type = 0.0;
+	for (unsigned int seed = 1U; seed <= num_runs; seed++) {
+		pt_config.put("run.regions.region.rng_seed", seed);
+		pt_config.put("run.cluster_scheduling", "Balanced");
+		mean_balanced += runSimulator(pt_config).cases.back() / static_cast<double>(num_runs);
+		pt_config.put("run.cluster_scheduling", "PerType");
+		mean_per_type += runSimulator(pt_config).cases.back() / static_cast<double>(num_runs);
+	}
+	EXPECT_NEAR(mean_balanced, mean_per_type, 0.05 * mean_per_type);
+}
+
 class Scenarios__BatchDemos: public ::testing::TestWithParam<tuple<string, unsigned int>> {
 protected:
 
@@ -11,6 +11,7 @@
 #include "sim/Simulator.h"
 
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <gtest/gtest.h>
@@ -75,6 +76,65 @@ TEST_P(Scenarios__HDF5, StartFromCheckpoints) {
 	}
 }
 
+TEST_F(Scenarios__HDF5, StartFromDeltaCheckpoints) {
+	const unsigned int num_days = 20;
+	const string h5filename = "testOutput.h5";
+	auto pt_config = getConfigTree();
+
+	// Keyframes at timesteps 0, 4, 8, ...: the others only hold the changes.
+	shared_ptr<Simulator> sim = SimulatorBuilder::build(pt_config);
+	auto classInstance = std::make_shared<Hdf5Saver>
+		(Hdf5Saver(h5filename.c_str(), pt_config, 1, RunMode::Initial, 0, false, 4));
+	std::function<void(const Simulator&)> fnCaller = std::bind(&Hdf5Saver::update, classInstance, std::placeholders::_1);
+	sim->registerObserver(classInstance, fnCaller);
+
+	sim->notify(*sim);
+	vector<vector<unsigned int>> status_original;
+	vector<vector<PersonIndex>> households_original;
+	for (unsigned int i = 0; i <= num_days; i++) {
+		if (i > 0) {
+			sim->timeStep();
+		}
+		status_original.emplace_back();
+		for (const auto& person: sim->getPopulation()->m_original) {
+			status_original.back().push_back((unsigned int) person.getHealth().getHealthStatus());
+		}
+		households_original.emplace_back();
+		for (const auto& household: sim->getClusters(ClusterType::Household)) {
+			auto members = household.getMembers();
+			sort(members.begin(), members.end());
+			households_original.back().insert(households_original.back().end(), members.begin(), members.end());
+		}
+	}
+	const unsigned int num_cases_original = sim->getPopulation()->getInfectedCount();
+
+	for (unsigned int i = 1; i < num_days; i++) {
+		Hdf5Loader hdf5_loader(h5filename.c_str());
+		auto sim_checkpointed = SimulatorBuilder::build(hdf5_loader.getConfig(), hdf5_loader.getDisease(), hdf5_loader.getContact());
+		hdf5_loader.loadFromTimestep(i, sim_checkpointed);
+
+		vector<unsigned int> status;
+		for (const auto& person: sim_checkpointed->getPopulation()->m_original) {
+			status.push_back((unsigned int) person.getHealth().getHealthStatus());
+		}
+		ASSERT_EQ(status_original.at(i), status);
+
+		// The same members, their order is rebuilt and the run goes on as the original one.
+		vector<PersonIndex> households;
+		for (const auto& household: sim_checkpointed->getClusters(ClusterType::Household)) {
+			auto members = household.getMembers();
+			sort(members.begin(), members.end());
+			households.insert(households.end(), members.begin(), members.end());
+		}
+		ASSERT_EQ(households_original.at(i), households);
+
+		for (unsigned int j = i; j < num_days; j++) {
+			sim_checkpointed->timeStep();
+		}
+		ASSERT_EQ(num_cases_original, sim_checkpointed->getPopulation()->getInfectedCount());
+	}
+}
+
 
 #if UNIPAR_IMPL == UNIPAR_DUMMY
 	unsigned int threads_hdf5scenarios[] { 1U };
@@ -1,5 +1,7 @@
 #ifdef HDF5_USED
 #include "checkpointing/Hdf5Saver.h"
+#include "checkpointing/Hdf5Loader.h"
+#include "checkpointing/Hdf5Writer.h"
 #include "sim/SimulatorBuilder.h"
 #include "sim/Simulator.h"
 #include "pop/Population.h"
@@ -204,6 +206,162 @@ TEST_F(UnitTests__HDF5, CheckAmtPersons) {
 	 EXPECT_EQ(sim->getPopulation().get()->m_original.size(), dims_person_TI[0]);
 }
 
+/**
+ *	Test that checkpoints written in the background hold the state of their own timestep.
+ */
+TEST_F(UnitTests__HDF5, BackgroundSave) {
+	const string h5filename = "testOutput.h5";
+	auto pt_config = getConfigTree();
+
+	shared_ptr<Simulator> sim = SimulatorBuilder::build(pt_config);
+	auto classInstance = std::make_shared<Hdf5Saver>(Hdf5Saver(h5filename.c_str(), pt_config, 1, RunMode::Initial, 0, true));
+	auto fnCaller = std::bind(&Hdf5Saver::update, classInstance, std::placeholders::_1);
+	sim->registerObserver(classInstance, fnCaller);
+	sim->notify(*sim);
+
+	vector<unsigned int> health_status;
+	for (unsigned int i = 0; i < 5; i++) {
+		sim->timeStep();
+		if (i == 2) {
+			for (const auto& person: sim->getPopulation()->m_original) {
+				health_status.push_back((unsigned int) person.getHealth().getHealthStatus());
+			}
+		}
+	}
+	classInstance->flush();
+
+	H5File h5file (h5filename.c_str(), H5F_ACC_RDONLY);
+	DataSet dataset = h5file.openDataSet("amt_timesteps");
+	unsigned int hdf5_timesteps[1];
+	dataset.read(hdf5_timesteps, PredType::NATIVE_UINT);
+	dataset.close();
+	EXPECT_EQ(6U, hdf5_timesteps[0]);
+
+	dataset = h5file.openDataSet("Timestep_000003/person_time_dependent");
+	vector<PersonTDDataType> persons(health_status.size());
+	dataset.read(persons.data(), PersonTDDataType::getCompType());
+	dataset.close();
+	h5file.close();
+
+	for (unsigned int i = 0; i < persons.size(); i++) {
+		ASSERT_EQ(health_status[i], persons[i].m_health_status);
+	}
+}
+
+/**
+ *	Test that compressed checkpoints are filtered and load like the others.
+ */
+TEST_F(UnitTests__HDF5, CompressedCheckpoint) {
+	const string h5filename = "testOutput.h5";
+	auto pt_config = getConfigTree();
+	pt_config.put("run.outputs.checkpointing.<xmlattr>.compression", "deflate");
+	pt_config.put("run.outputs.checkpointing.<xmlattr>.shuffle", true);
+
+	shared_ptr<Simulator> sim = SimulatorBuilder::build(pt_config);
+	auto classInstance = std::make_shared<Hdf5Saver>(Hdf5Saver(h5filename.c_str(), pt_config, 1));
+	auto fnCaller = std::bind(&Hdf5Saver::update, classInstance, std::placeholders::_1);
+	sim->registerObserver(classInstance, fnCaller);
+	sim->notify(*sim);
+	sim->timeStep();
+	sim->timeStep();
+
+	H5File h5file (h5filename.c_str(), H5F_ACC_RDONLY);
+	DataSet dataset = h5file.openDataSet("Timestep_000002/household_clusters");
+	EXPECT_EQ(2, dataset.getCreatePlist().getNfilters());
+	dataset.close();
+	h5file.close();
+
+	Hdf5Loader hdf5_loader(h5filename.c_str());
+	auto sim_checkpointed = SimulatorBuilder::build(hdf5_loader.getConfig(), hdf5_loader.getDisease(), hdf5_loader.getContact());
+	hdf5_loader.loadFromTimestep(2, sim_checkpointed);
+	const auto& persons = sim->getPopulation()->m_original;
+	const auto& persons_checkpointed = sim_checkpointed->getPopulation()->m_original;
+	ASSERT_EQ(persons.size(), persons_checkpointed.size());
+	for (unsigned int i = 0; i < persons.size(); i++) {
+		ASSERT_EQ(persons[i].getHealth().getHealthStatus(), persons_checkpointed[i].getHealth().getHealthStatus());
+	}
+
+	pt_config.put("run.outputs.checkpointing.<xmlattr>.compression", "lzma");
+	EXPECT_THROW(Hdf5Saver(h5filename.c_str(), pt_config, 1), runtime_error);
+}
+
+
+/**
+ *	Test that simulators sharing a writer save into their own group of one file.
+ */
+TEST_F(UnitTests__HDF5, SingleFileCheckpoints) {
+	const string h5filename = "testOutput.h5";
+	auto pt_config = getConfigTree();
+	auto writer = std::make_shared<Hdf5Writer>(h5filename, false);
+
+	const vector<string> regions {"first", "second"};
+	vector<shared_ptr<Simulator>> sims;
+	vector<shared_ptr<Hdf5Saver>> savers;
+	for (unsigned int r = 0; r < regions.size(); r++) {
+		pt_config.put("run.regions.region.rng_seed", 1 + r);
+		sims.push_back(SimulatorBuilder::build(pt_config));
+		savers.push_back(std::make_shared<Hdf5Saver>(writer, regions[r], pt_config, 1));
+		auto fnCaller = std::bind(&Hdf5Saver::update, savers[r], std::placeholders::_1);
+		sims[r]->registerObserver(savers[r], fnCaller);
+		sims[r]->notify(*sims[r]);
+	}
+	for (unsigned int i = 0; i < 3; i++) {
+		for (auto& sim: sims) {
+			sim->timeStep();
+		}
+	}
+	writer->flush();
+
+	for (unsigned int r = 0; r < regions.size(); r++) {
+		Hdf5Loader hdf5_loader(h5filename.c_str(), regions[r]);
+		EXPECT_EQ(3U, hdf5_loader.getLastSavedTimestep());
+		auto sim_checkpointed = SimulatorBuilder::build(hdf5_loader.getConfig(), hdf5_loader.getDisease(), hdf5_loader.getContact());
+		hdf5_loader.loadFromTimestep(3, sim_checkpointed);
+		const auto& persons = sims[r]->getPopulation()->m_original;
+		const auto& persons_checkpointed = sim_checkpointed->getPopulation()->m_original;
+		ASSERT_EQ(persons.size(), persons_checkpointed.size());
+		for (unsigned int i = 0; i < persons.size(); i++) {
+			ASSERT_EQ(persons[i].getHealth().getHealthStatus(), persons_checkpointed[i].getHealth().getHealthStatus());
+		}
+	}
+}
+
+
+/**
+ *	Test that persons load in chunks that do not line up with the chunks they were saved in.
+ */
+TEST_F(UnitTests__HDF5, LoadPersonsInChunks) {
+	const string h5filename = "testOutput.h5";
+	auto pt_config = getConfigTree();
+	pt_config.put("run.outputs.checkpointing.<xmlattr>.chunk_size", 7000);
+
+	shared_ptr<Simulator> sim = SimulatorBuilder::build(pt_config);
+	auto classInstance = std::make_shared<Hdf5Saver>(Hdf5Saver(h5filename.c_str(), pt_config, 1));
+	auto fnCaller = std::bind(&Hdf5Saver::update, classInstance, std::placeholders::_1);
+	sim->registerObserver(classInstance, fnCaller);
+	sim->notify(*sim);
+	for (unsigned int i = 0; i < 3; i++) {
+		sim->timeStep();
+	}
+
+	// More persons than the 40000 that are read at once, and not a multiple of that.
+	const auto& population = *sim->getPopulation();
+	const auto& persons = population.m_original;
+	ASSERT_GT(persons.size(), 40000U);
+	ASSERT_NE(persons.size() % 40000U, 0U);
+
+	Hdf5Loader hdf5_loader(h5filename.c_str());
+	auto sim_checkpointed = SimulatorBuilder::build(hdf5_loader.getConfig(), hdf5_loader.getDisease(), hdf5_loader.getContact());
+	hdf5_loader.loadFromTimestep(3, sim_checkpointed);
+	const auto& population_checkpointed = *sim_checkpointed->getPopulation();
+	ASSERT_EQ(persons.size(), population_checkpointed.m_original.size());
+	for (unsigned int i = 0; i < persons.size(); i++) {
+		ASSERT_EQ(population.getHealthStatus(i), population_checkpointed.getHealthStatus(i));
+		ASSERT_EQ(population.getDiseaseCounter(i), population_checkpointed.getDiseaseCounter(i));
+		ASSERT_EQ(persons[i].isOnVacation(), population_checkpointed.m_original[i].isOnVacation());
+	}
+}
+
 
 unsigned int checkpointing_frequencies[] { 1U, 2U, 0U };
 
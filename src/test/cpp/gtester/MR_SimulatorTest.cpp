@@ -199,7 +199,8 @@ TEST_F(UnitTests__MR_SimulatorTest, destinationClusters) {
 		ASSERT_NO_THROW(m_sim2->getClusters(ClusterType::SecondaryCommunity).at(sec_comm_index));
 
 		// Test every cluster on the presence of this person
-		auto search_person = [&] (const pair<Simulator::PersonType*, bool> person_presence_pair) {return person.get() == person_presence_pair.first;};
+		const PersonIndex person_index = m_sim2->getPopulation()->getIndex(person.get());
+		auto search_person = [&] (PersonIndex member) {return person_index == member;};
 
 		auto it = find_if(m_sim2->getClusters(ClusterType::Work).at(work_index).getMembers().begin(),
 							m_sim2->getClusters(ClusterType::Work).at(work_index).getMembers().end(),
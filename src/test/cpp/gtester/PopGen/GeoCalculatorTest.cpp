@@ -11,6 +11,7 @@
 #include <string>
 #include <random>
 #include <iostream>
+#include <vector>
 
 using namespace std;
 using namespace stride;
@@ -67,6 +68,50 @@ TEST(UnitTests_GeoCalculatorTest, distance_default) {
 				calc.getDistance(GeoCoordinate(-52.142, 180.0), GeoCoordinate(43.21, 65.2)));
 }
 
+TEST(UnitTests_GeoCalculatorTest, batch_default) {
+	// The batch functions give the results of getDistance (up to rounding, the terms are computed in another order)
+	const GeoCoordCalculator& calc = GeoCoordCalculator::getInstance();
+	mt19937 rng(5U);
+	uniform_real_distribution<double> latitude(-90.0, 90.0);
+	uniform_real_distribution<double> longitude(-180.0, 180.0);
+	vector<GeoCoordinate> coords;
+	for (uint i = 0; i < 500; i++) {
+		coords.emplace_back(latitude(rng), longitude(rng));
+	}
+	coords.emplace_back(90.0, 15.142);
+	coords.emplace_back(-52.142, -180.0);
+	const GeoCoordBatch batch(coords);
+	const GeoCoordBatch origins(vector<GeoCoordinate>(coords.begin(), coords.begin() + 10));
+
+	vector<double> distances;
+	calc.getDistances(origins, batch, distances);
+	ASSERT_EQ(origins.size() * coords.size(), distances.size());
+	for (uint i = 0; i < origins.size(); i++) {
+		for (uint j = 0; j < coords.size(); j++) {
+			EXPECT_NEAR(calc.getDistance(coords[i], coords[j]), distances[i * coords.size() + j], 1e-6);
+		}
+	}
+
+	for (double radius: {0.0, 10.0, 1500.0, 9000.0, 19000.0, 25000.0}) {
+		for (uint i = 0; i < origins.size(); i++) {
+			vector<uint> positions;
+			vector<double> within_distances;
+			calc.findWithin(coords[i], radius, batch, 1, coords.size(), positions, &within_distances);
+			vector<uint> expected;
+			for (uint j = 1; j < coords.size(); j++) {
+				if (calc.getDistance(coords[i], coords[j]) <= radius) {
+					expected.push_back(j);
+				}
+			}
+			EXPECT_EQ(expected, positions);
+			ASSERT_EQ(positions.size(), within_distances.size());
+			for (uint j = 0; j < positions.size(); j++) {
+				EXPECT_NEAR(distances[i * coords.size() + positions[j]], within_distances[j], 1e-6);
+			}
+		}
+	}
+}
+
 TEST(UnitTests_GeoCalculatorTest, convertToRegularCoordinates_default) {
 	// Test whether this is actually written according to the singleton pattern
 
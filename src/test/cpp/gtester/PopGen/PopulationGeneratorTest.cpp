@@ -5,8 +5,10 @@
 
 #include "popgen/PopulationGenerator.cpp"
 #include "popgen/FamilyParser.h"
+#include "pop/PopulationFile.h"
 #include "util/StringUtils.h"
 #include "util/InstallDirs.h"
+#include "util/unipar.h"
 
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
@@ -284,6 +286,45 @@ TEST(PopulationGeneratorTest, HappyDay_default) {
 
 }
 
+TEST(PopulationGeneratorTest, Parallel_default) {
+	// The parallel mode gives a valid population that does not depend on the number of threads
+	// (with the dummy implementation of unipar everything runs on one thread, so only the population is checked)
+
+	PopulationGenerator<mt19937> gen4 {"happy_day.xml", 1, false, 4};
+	gen4.generate("test_parallel4");
+
+	checkHappyDayCities(readCSV("test_parallel4_districts.csv"));
+	checkHappyDayPop("test_parallel4_people.csv", "households_flanders.txt");
+	checkHappyDayHouseHolds("test_parallel4_households.csv", "test_parallel4_people.csv");
+
+#if UNIPAR_IMPL != UNIPAR_DUMMY
+	PopulationGenerator<mt19937> gen1 {"happy_day.xml", 1, false, 1};
+	gen1.generate("test_parallel1");
+	for (const char* file: {"_people.csv", "_households.csv", "_clusters.csv"}) {
+		EXPECT_EQ(readCSV(string("test_parallel1") + file), readCSV(string("test_parallel4") + file));
+	}
+#endif
+}
+
+TEST(PopulationGeneratorTest, Output_default) {
+	// The binary people file holds the people of the csv file
+	PopulationGenerator<mt19937> gen_csv {"happy_day.xml", 1, false};
+	gen_csv.generate("test_output_csv");
+	PopulationGenerator<mt19937> gen_binary {"happy_day.xml", 1, false};
+	gen_binary.generate("test_output_binary", false, true);
+
+	const auto csv = readCSV("test_output_csv_people.csv");
+	const PopulationFile pop_file((InstallDirs::getDataDir() /= "test_output_binary_people.bin").string());
+	ASSERT_EQ(csv.size() - 1, pop_file.size());
+	for (size_t i = 0; i < pop_file.size(); i++) {
+		for (size_t c = 0; c < 6; c++) {
+			EXPECT_EQ(StringUtils::fromString<unsigned int>(csv[i + 1][c]),
+					  pop_file.getColumn(static_cast<PopulationFile::Column>(c))[i]);
+		}
+	}
+	EXPECT_EQ(readCSV("test_output_csv_households.csv"), readCSV("test_output_binary_households.csv"));
+}
+
 TEST(PopulationGeneratorTest, UnhappyDay_default) {
 	// Test invalid files, files with syntax errors, files with semantic errors,...
 	EXPECT_THROW(PopulationGenerator<std::mt19937>("no_cities.xml", false), invalid_argument);
@@ -4,7 +4,16 @@
 #include <gtest/gtest.h>
 
 #include "pop/Population.h"
+#include "pop/PopulationFile.h"
 #include "sim/Simulator.h"
+#include "util/InstallDirs.h"
+#include "util/StringUtils.h"
+#include "util/unipar.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <functional>
+#include <random>
 
 using namespace std;
 using namespace stride;
@@ -123,4 +132,144 @@ VARIOUS_POPULATION_TESTS(UnitTests__EmptyPopulationTest, 0)
 VARIOUS_POPULATION_TESTS(UnitTests__PopulationTest, 0)
 
 
+/// Take a population through infections, travel and a checkpoint load, next to a copy of the Health of everyone
+/// that is updated every day (the reference, it keeps being updated while away, as by the region visited).
+/// The check gets the population, the reference and who is away, at the end of every day.
+void runHealthScenario(const function<void(const Population&, const vector<Health>&, const vector<bool>&)>& check) {
+	const unsigned int size = 10000U;
+	Population pop;
+	for (unsigned int i = 0; i < size; i++) {
+		pop.m_original.emplace_back(i, i % 90U, 0, 0, 0, 0, 0, 1 + i % 4U, 2 + i % 5U, 3 + i % 6U, 2 + i % 7U);
+		if (i % 13U == 0U) {
+			pop.m_original.back().getHealth().setImmune();
+		}
+	}
+	pop.syncColumns();
+	vector<Health> reference;
+	for (const auto& p: pop.m_original) {
+		reference.push_back(p.getHealth());
+	}
+	vector<bool> away(size, false);
+
+	Parallel parallel(4);
+	mt19937 rng(42U);
+	for (unsigned int day = 1; day <= 40U; day++) {
+		pop.update(false, false, pop.getFractionInfected(), parallel);
+		for (auto& health: reference) {
+			health.update();
+		}
+
+		// New infections, and some of the infected are infected again.
+		for (unsigned int k = 0; k < size / 100U; k++) {
+			const PersonIndex i = rng() % size;
+			const auto status = pop.getHealthStatus(i);
+			if (!away[i] && (status == HealthStatus::Susceptible || (Health::isInfected(status) && k % 5U == 0U))) {
+				pop.startInfection(i);
+				reference[i].startInfection();
+			}
+		}
+
+		// Travel: leave on day 8, come back on day 14 (with the health from abroad).
+		for (PersonIndex i = 0; i < size; i += 37U) {
+			auto& person = pop.m_original[i];
+			if (day == 8U) {
+				pop.syncHealth(i);
+				person.setOnVacation(true);
+				pop.syncColumns(i);
+				away[i] = true;
+			} else if (day == 14U) {
+				person.setOnVacation(false);
+				person.getHealth() = reference[i];
+				pop.syncColumns(i);
+				away[i] = false;
+			}
+		}
+
+		// Checkpoint: save the records, and load them again.
+		if (day == 22U) {
+			for (PersonIndex i = 0; i < size; i++) {
+				pop.syncHealth(i);
+				pop.m_original[i].getHealth() = reference[i];
+			}
+			pop.syncColumns();
+		}
+
+		check(pop, reference, away);
+	}
+}
+
+TEST(UnitTests__PopulationHealthTest, EventDriven) {
+	// The calendar queue gives everyone the health of the daily update.
+	unsigned int num_infected = 0U;
+	runHealthScenario([&](const Population& pop, const vector<Health>& reference, const vector<bool>& away) {
+		unsigned int mismatches = 0U;
+		for (PersonIndex i = 0; i < reference.size(); i++) {
+			if (!away[i]) {
+				const auto status = reference[i].getHealthStatus();
+				mismatches += pop.getHealthStatus(i) != status
+							  || pop.getPerson(i).getHealth().getHealthStatus() != status
+							  || pop.getDiseaseCounter(i) != reference[i].getDiseaseCounter();
+			}
+		}
+		EXPECT_EQ(0U, mismatches);
+		num_infected = pop.getInfectedCount();
+	});
+	EXPECT_GT(num_infected, 1000U);
+}
+
+TEST(UnitTests__PopulationHealthTest, Counts) {
+	// The counts kept by the population are those of a recount of everyone present.
+	unsigned int num_recovered = 0U;
+	runHealthScenario([&](const Population& pop, const vector<Health>&, const vector<bool>& away) {
+		PopulationStats::Counts counts {};
+		unsigned int present = 0U;
+		for (PersonIndex i = 0; i < away.size(); i++) {
+			if (!away[i]) {
+				counts[static_cast<size_t>(pop.getPerson(i).getHealth().getHealthStatus())]++;
+				present++;
+			}
+		}
+
+		const auto stats = pop.getStats();
+		for (size_t status = 0; status < counts.size(); status++) {
+			EXPECT_EQ(counts[status], stats.getCount(static_cast<HealthStatus>(status)));
+		}
+		EXPECT_EQ(present, stats.getPresentCount());
+		const unsigned int infected = present - counts[static_cast<size_t>(HealthStatus::Susceptible)]
+									  - counts[static_cast<size_t>(HealthStatus::Immune)];
+		EXPECT_EQ(infected, pop.getInfectedCount());
+		EXPECT_DOUBLE_EQ(static_cast<double>(infected) / present, pop.getFractionInfected());
+		num_recovered = counts[static_cast<size_t>(HealthStatus::Recovered)];
+	});
+	EXPECT_GT(num_recovered, 0U);
+}
+
+TEST(UnitTests__PopulationFileTest, ConvertCsv) {
+	const auto csv_path = InstallDirs::getDataDir() /= string("smallpop_people.csv");
+	const auto binary_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	PopulationFile::convert(csv_path.string(), binary_path.string());
+
+	{
+		const PopulationFile pop_file(binary_path.string());
+		ifstream csv_file(csv_path.string());
+		string line;
+		getline(csv_file, line);
+		size_t i = 0;
+		while (getline(csv_file, line)) {
+			const auto values = StringUtils::split(line, ",");
+			ASSERT_LT(i, pop_file.size());
+			EXPECT_EQ(StringUtils::fromString<unsigned int>(values[0]), pop_file.getColumn(PopulationFile::Column::Age)[i]);
+			EXPECT_EQ(StringUtils::fromString<unsigned int>(values[5]),
+					  pop_file.getColumn(PopulationFile::Column::SecondaryCommunity)[i]);
+			i++;
+		}
+		EXPECT_EQ(i, pop_file.size());
+		EXPECT_EQ(nullptr, pop_file.getRiskAverseness());
+	}
+	boost::filesystem::remove(binary_path);
+
+	EXPECT_THROW(PopulationFile(csv_path.string()), runtime_error);
+}
+
+
 }
@@ -3,7 +3,18 @@
 
 #include <gtest/gtest.h>
 
+#include "util/GeoCoordCalculator.h"
+#include "util/GeoGrid.h"
+#include "util/InstallDirs.h"
+#include "util/MappedCsv.h"
+#include "util/Random.h"
+#include "util/Sampling.h"
 #include "util/SimplePlanner.h"
+#include "util/StringUtils.h"
+
+#include <fstream>
+#include <numeric>
+#include <set>
 
 using namespace std;
 using namespace stride;
@@ -47,4 +58,116 @@ TEST(UnitTests__Utils, SimplePlanner) {
 	EXPECT_EQ(planner.getDay(1345)->size(), 0);
 }
 
+TEST(UnitTests__Utils, GeometricSkip) {
+	Random rng(1);
+	EXPECT_EQ(rng.nextGeometricSkip(1.0, 100), 0U);
+	EXPECT_EQ(rng.nextGeometricSkip(0.0, 100), 100U);
+	EXPECT_EQ(rng.nextGeometricSkip(1e-12, 100), 100U);
+
+	// The mean number of failures before a success is (1 - p) / p.
+	const double probability = 0.1;
+	const unsigned int draws = 100000;
+	double total = 0.0;
+	for (unsigned int i = 0; i < draws; i++) {
+		total += rng.nextGeometricSkip(probability, 1000000);
+	}
+	EXPECT_NEAR(total / draws, (1 - probability) / probability, 0.2);
+}
+
+TEST(UnitTests__Utils, MappedCsv) {
+	// Parsed in parallel, but in the order of the file (as with getline).
+	const auto file_path = (InstallDirs::getDataDir() /= string("bigpop_clusters.csv")).string();
+	Parallel parallel;
+	const auto lines = MappedCsv(file_path).parse<pair<string, double>>(
+			[](const MappedCsv::Field* fields, size_t num_fields) {
+				EXPECT_EQ(num_fields, 4U);
+				return make_pair(fields[1].toString(), fields[2].toDouble());
+			}, parallel);
+
+	ifstream file(file_path);
+	string line;
+	getline(file, line);
+	size_t i = 0;
+	while (getline(file, line)) {
+		const auto values = StringUtils::split(line, ",");
+		ASSERT_LT(i, lines.size());
+		EXPECT_EQ(values[1], lines[i].first);
+		EXPECT_EQ(StringUtils::fromString<double>(values[2]), lines[i].second);
+		i++;
+	}
+	EXPECT_EQ(i, lines.size());
+}
+
+TEST(UnitTests__Utils, SamplingWithoutReplacement) {
+	Random rng(3);
+	vector<unsigned int> candidates(1000);
+	iota(candidates.begin(), candidates.end(), 0U);
+	shuffleFront(candidates, 990, rng);
+	EXPECT_EQ(set<unsigned int>(candidates.begin(), candidates.end()).size(), 1000U);
+
+	const auto samples = sampleIndices(1000, 990, rng);
+	const set<unsigned int> unique(samples.begin(), samples.end());
+	EXPECT_EQ(unique.size(), 990U);
+	EXPECT_LT(*unique.rbegin(), 1000U);
+	EXPECT_THROW(sampleIndices(10, 11, rng), runtime_error);
+
+	// Distinct numbers in range, also when choosing none, all or all but one.
+	for (const unsigned int num_samples: {0U, 1U, 99U, 100U}) {
+		const auto chosen = sampleIndices(100, num_samples, rng);
+		const set<unsigned int> distinct(chosen.begin(), chosen.end());
+		EXPECT_EQ(chosen.size(), num_samples);
+		EXPECT_EQ(distinct.size(), num_samples);
+		EXPECT_TRUE(distinct.empty() || *distinct.rbegin() < 100U);
+	}
+
+	// Every number (candidate) is chosen about equally often: 3 out of 10, so 3000 times in 10000 draws.
+	const unsigned int draws = 10000;
+	vector<unsigned int> count_indices(10, 0U);
+	vector<unsigned int> count_front(10, 0U);
+	for (unsigned int i = 0; i < draws; i++) {
+		for (const auto sample: sampleIndices(10, 3, rng)) {
+			count_indices[sample]++;
+		}
+		vector<unsigned int> numbers(10);
+		iota(numbers.begin(), numbers.end(), 0U);
+		shuffleFront(numbers, 3, rng);
+		for (unsigned int j = 0; j < 3; j++) {
+			count_front[numbers[j]]++;
+		}
+	}
+	for (unsigned int j = 0; j < 10; j++) {
+		EXPECT_NEAR(count_indices[j], 3000.0, 250.0);
+		EXPECT_NEAR(count_front[j], 3000.0, 250.0);
+	}
+}
+
+TEST(UnitTests__Utils, GeoGridFindWithin) {
+	Random rng(5);
+	vector<GeoCoordinate> points;
+	for (unsigned int i = 0; i < 2000; i++) {
+		points.emplace_back(50.0 + rng.nextDouble() * 2.0, 3.0 + rng.nextDouble() * 3.0);
+	}
+	points.emplace_back(51.0, 4.0);
+	points.emplace_back(51.0, 4.0);
+	const GeoGrid grid(points);
+	const auto& calc = GeoCoordCalculator::getInstance();
+
+	// The same points, in the same order, as when all of them are checked.
+	vector<unsigned int> found;
+	for (const double radius: {0.0, 1.0, 10.0, 50.0, 500.0, 20000.0}) {
+		for (const auto& center: {GeoCoordinate(51.0, 4.0), GeoCoordinate(49.5, 2.0), GeoCoordinate(-30.0, 179.9)}) {
+			vector<unsigned int> expected;
+			for (unsigned int i = 0; i < points.size(); i++) {
+				if (calc.getDistance(center, points[i]) <= radius) {
+					expected.push_back(i);
+				}
+			}
+			grid.findWithin(center, radius, found);
+			EXPECT_EQ(expected, found);
+		}
+	}
+	GeoGrid().findWithin(GeoCoordinate(51.0, 4.0), 100.0, found);
+	EXPECT_TRUE(found.empty());
+}
+
 }